@@ -1,8 +1,37 @@
 #include "src/MicroCore.h"
 #include "src/CmdLineOptions.h"
+#include "src/RingAnalyzer.h"
+#include "src/RingPrinter.h"
+#include "src/AsyncRingAnalyzer.h"
+#include "src/RingColumns.h"
+#include "src/ring_verify.h"
+#include "src/hash_file.h"
+#include "src/KeyImageIndex.h"
+#include "src/decoy_exposure.h"
+#include "src/spend_age.h"
+#include "src/PaymentIdIndex.h"
+#include "src/owned_outputs.h"
+#include "src/AccountSet.h"
+#include "src/OutputScanner.h"
+#include "src/ScanCheckpoint.h"
+#include "src/chain_scan.h"
+#include "src/ChainFollower.h"
+#include "src/RingCache.h"
+#include "src/RingGraph.h"
+#include "src/ZeroMixinCascade.h"
+#include "src/DecoyCounter.h"
 
 #include "ext/format.h"
 
+#include <deque>
+#include <future>
+#include <cstdio>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <memory>
+#include <chrono>
+
 using namespace std;
 using namespace fmt;
 
@@ -26,34 +55,164 @@ int main(int ac, const char* av[]) {
         return 0;
     }
 
+    auto bench_scanner_opt = opts.get_option<size_t>("bench-scanner");
+
+    // compare crypto::derive_public_key with OutputScanner and finish
+    if (bench_scanner_opt)
+    {
+        array<double, 2> times = xmreg::benchmark_output_scanner(*bench_scanner_opt);
+
+        print("Outputs derived         : {:d}\n", *bench_scanner_opt);
+        print("derive_public_key       : {:0.3f} s\n", times[0]);
+        print("OutputScanner           : {:0.3f} s\n", times[1]);
+        print("Speedup                 : {:0.2f}x\n",
+              times[1] > 0 ? times[0] / times[1] : 0.0);
+
+        return 0;
+    }
+
+
+    auto bench_hex_opt = opts.get_option<size_t>("bench-hex");
+
+    // compare epee's pod_to_hex with hex_encode and finish
+    if (bench_hex_opt)
+    {
+        array<double, 2> times = xmreg::benchmark_hex_encoding(*bench_hex_opt);
+
+        print("Keys encoded            : {:d}\n", *bench_hex_opt);
+        print("pod_to_hex              : {:0.3f} s\n", times[0]);
+        print("hex_encode              : {:0.3f} s\n", times[1]);
+        print("Speedup                 : {:0.2f}x\n",
+              times[1] > 0 ? times[0] / times[1] : 0.0);
+
+        return 0;
+    }
+
 
     // flag indicating if viewkey and address were
     // given by the user
     bool VIEWKEY_AND_ADDRESS_GIVEN {false};
 
     // get other options
-    auto tx_hash_opt = opts.get_option<string>("txhash");
+    auto tx_hash_opt = opts.get_option<vector<string>>("txhash");
+    auto tx_hash_file_opt = opts.get_option<string>("txhash-file");
     auto viewkey_opt = opts.get_option<string>("viewkey");
     auto address_opt = opts.get_option<string>("address");
     auto bc_path_opt = opts.get_option<string>("bc-path");
     bool testnet     = *(opts.get_option<bool>("testnet"));
+    size_t prefetch_no = *(opts.get_option<size_t>("prefetch"));
+    auto spendkey_opt     = opts.get_option<string>("spendkey");
+    bool key_images_mode  = *(opts.get_option<bool>("key-images"));
+    bool spend_ages_mode  = *(opts.get_option<bool>("spend-ages"));
+    auto from_height_opt  = opts.get_option<size_t>("from-height");
+    auto to_height_opt    = opts.get_option<size_t>("to-height");
+    size_t thread_no      = *(opts.get_option<size_t>("threads"));
+    auto accounts_file_opt = opts.get_option<string>("accounts-file");
+    bool scan_outputs_mode = *(opts.get_option<bool>("scan-outputs"));
+    bool decoy_exposure_mode = *(opts.get_option<bool>("decoy-exposure"));
+    auto checkpoint_opt    = opts.get_option<string>("checkpoint");
+    auto from_date_opt     = opts.get_option<string>("from-date");
+    auto to_date_opt       = opts.get_option<string>("to-date");
+    bool follow_mode       = *(opts.get_option<bool>("follow"));
+    size_t poll_interval_ms = *(opts.get_option<size_t>("poll-interval"));
+    size_t reorg_depth     = *(opts.get_option<size_t>("reorg-depth"));
+    bool analyze_blocks_mode = *(opts.get_option<bool>("analyze-blocks"));
+    bool verify_mode       = *(opts.get_option<bool>("verify"));
+    bool verify_blocks_mode = *(opts.get_option<bool>("verify-blocks"));
+    auto build_ring_cache_opt = opts.get_option<string>("build-ring-cache");
+    auto ring_cache_opt    = opts.get_option<string>("ring-cache");
+    auto build_ring_graph_opt = opts.get_option<string>("build-ring-graph");
+    auto ring_graph_opt    = opts.get_option<string>("ring-graph");
+    auto build_decoy_counts_opt = opts.get_option<string>("build-decoy-counts");
+    auto decoy_counts_opt  = opts.get_option<string>("decoy-counts");
+    auto build_keyimage_index_opt = opts.get_option<string>("build-keyimage-index");
+    auto keyimage_index_opt = opts.get_option<string>("keyimage-index");
+    auto keyimage_opt      = opts.get_option<vector<string>>("keyimage");
+    auto build_payment_id_index_opt = opts.get_option<string>("build-payment-id-index");
+    auto payment_id_index_opt = opts.get_option<string>("payment-id-index");
+    auto payment_id_opt    = opts.get_option<vector<string>>("payment-id");
+    bool no_color          = *(opts.get_option<bool>("no-color"));
+    auto ring_columns_opt  = opts.get_option<string>("ring-columns");
+    auto ndjson_opt        = opts.get_option<string>("ndjson");
 
 
     // get the program command line options, or
     // some default values for quick check
-    string tx_hash_str = tx_hash_opt ?
+    vector<string> tx_hash_strs = tx_hash_opt ?
                          *tx_hash_opt :
-                         "09d9e8eccf82b3d6811ed7005102caf1b605f325cf60ed372abeb4a67d956fff";
+                         vector<string> {"09d9e8eccf82b3d6811ed7005102caf1b605f325cf60ed372abeb4a67d956fff"};
 
+    // only hashes from the file, if no other were given
+    if (!tx_hash_opt && tx_hash_file_opt)
+    {
+        tx_hash_strs.clear();
+    }
 
-    crypto::hash tx_hash;
+    // parse all the tx hashes given
+    vector<crypto::hash> tx_hashes;
 
-    if (!xmreg::parse_str_secret_key(tx_hash_str, tx_hash))
+    for (const string& tx_hash_str: tx_hash_strs)
     {
-        cerr << "Cant parse tx hash: " << tx_hash_str << endl;
-        return 1;
+        crypto::hash tx_hash;
+
+        if (!xmreg::parse_str_secret_key(tx_hash_str, tx_hash))
+        {
+            cerr << "Cant parse tx hash: " << tx_hash_str << endl;
+            return 1;
+        }
+
+        tx_hashes.push_back(tx_hash);
+    }
+
+    // batch of tx hashes from a file
+    if (tx_hash_file_opt)
+    {
+        vector<xmreg::bad_hash_line> bad_lines;
+
+        if (!xmreg::read_hash_file(*tx_hash_file_opt, tx_hashes, bad_lines))
+        {
+            return 1;
+        }
+
+        for (const xmreg::bad_hash_line& bad_line: bad_lines)
+        {
+            cerr << "Cant parse tx hash in line " << bad_line.line_no
+                 << " of " << *tx_hash_file_opt << ": " << bad_line.line << endl;
+        }
+
+        if (!bad_lines.empty())
+        {
+            return 1;
+        }
+    }
+
+
+    // parse key images to find spending inputs of
+    vector<crypto::key_image> key_images;
+
+    if (keyimage_opt)
+    {
+        if (!keyimage_index_opt)
+        {
+            cerr << "Key image index not given: use --keyimage-index" << endl;
+            return 1;
+        }
+
+        for (const string& key_image_str: *keyimage_opt)
+        {
+            crypto::key_image k_image;
+
+            if (!xmreg::parse_str_secret_key(key_image_str, k_image))
+            {
+                cerr << "Cant parse key image: " << key_image_str << endl;
+                return 1;
+            }
+
+            key_images.push_back(k_image);
+        }
     }
 
+
     crypto::secret_key private_view_key;
     cryptonote::account_public_address address;
 
@@ -76,6 +235,72 @@ int main(int ac, const char* av[]) {
         VIEWKEY_AND_ADDRESS_GIVEN = true;
     }
 
+    // our keys prepared for checking outputs
+    unique_ptr<xmreg::OutputScanner> scanner;
+
+    if (VIEWKEY_AND_ADDRESS_GIVEN)
+    {
+        scanner.reset(new xmreg::OutputScanner {private_view_key,
+                                                address.m_spend_public_key});
+    }
+
+    // accounts to be checked together, if given
+    xmreg::AccountSet accounts;
+
+    if (accounts_file_opt)
+    {
+        if (!accounts.load_from_file(*accounts_file_opt, testnet))
+        {
+            return 1;
+        }
+    }
+
+    if (scan_outputs_mode && !VIEWKEY_AND_ADDRESS_GIVEN && accounts.empty())
+    {
+        cerr << "Scanning outputs requires address and viewkey, "
+             << "or an accounts file." << endl;
+        return 1;
+    }
+
+    if (decoy_exposure_mode && !VIEWKEY_AND_ADDRESS_GIVEN)
+    {
+        cerr << "Decoy exposure requires address and viewkey." << endl;
+        return 1;
+    }
+
+    crypto::secret_key private_spend_key;
+
+    if (key_images_mode || spend_ages_mode || (decoy_exposure_mode && spendkey_opt))
+    {
+        if (!VIEWKEY_AND_ADDRESS_GIVEN || !spendkey_opt)
+        {
+            // name the option that needs the keys
+            string mode_opt = key_images_mode ? "--key-images"
+                              : spend_ages_mode ? "--spend-ages"
+                              : "--decoy-exposure with --spendkey";
+
+            cerr << mode_opt << " requires address, viewkey and spendkey." << endl;
+            return 1;
+        }
+
+        // parse string representing given private spendkey
+        if (!xmreg::parse_str_secret_key(*spendkey_opt, private_spend_key))
+        {
+            cerr << "Cant parse spend key: " << *spendkey_opt << endl;
+            return 1;
+        }
+
+        // make sure the spend key matches the address given
+        crypto::public_key public_spend_key;
+
+        if (!crypto::secret_key_to_public_key(private_spend_key, public_spend_key)
+            || public_spend_key != address.m_spend_public_key)
+        {
+            cerr << "Spend key does not match the address given." << endl;
+            return 1;
+        }
+    }
+
 
     path blockchain_path;
 
@@ -118,246 +343,1236 @@ int main(int ac, const char* av[]) {
     print("Top block block time  : {:s}\n", xmreg::timestamp_to_str(current_blk_timestamp));
 
 
-    cryptonote::transaction tx;
+    // height range for the scanning modes
+    uint64_t from_height = from_height_opt ? *from_height_opt : 0;
+    uint64_t to_height   = to_height_opt   ? min<uint64_t>(*to_height_opt, height) : height;
 
+    // dates, if given, are turned into exact heights
+    // using timestamps of the blocks
     try
     {
-        // get transaction with given hash
-        tx = core_storage.get_db().get_tx(tx_hash);
+        if (from_date_opt
+            && !mcore.height_for_time(xmreg::date_to_timestamp(*from_date_opt),
+                                      from_height))
+        {
+            cerr << "Cant find height for date: " << *from_date_opt << endl;
+            return 1;
+        }
+
+        if (to_date_opt)
+        {
+            uint64_t to_height_for_date;
+
+            // the whole day of to-date is included
+            if (!mcore.height_for_time(xmreg::date_to_timestamp(*to_date_opt) + 24 * 3600,
+                                       to_height_for_date))
+            {
+                cerr << "Cant find height for date: " << *to_date_opt << endl;
+                return 1;
+            }
+
+            to_height = min<uint64_t>(to_height,
+                                      to_height_for_date > 0 ? to_height_for_date - 1 : 0);
+        }
     }
     catch (const std::exception& e)
     {
         cerr << e.what() << endl;
-        return false;
+        return 1;
     }
 
-    // get tx payment id if present
-    // checks for encrypted id first, and then for normal
+    // progress of a scan saved in a checkpoint file, if given
+    unique_ptr<xmreg::ScanCheckpoint> checkpoint;
+
+    auto open_checkpoint = [&](const string& scan_id)
+    {
+        if (!checkpoint_opt)
+        {
+            return;
+        }
+
+        checkpoint.reset(new xmreg::ScanCheckpoint {*checkpoint_opt, scan_id});
+
+        if (checkpoint->load())
+        {
+            print("\nResuming scan after block {:d} from {}\n",
+                  checkpoint->last_height(), *checkpoint_opt);
+        }
+
+        // save the checkpoint on ctrl+c
+        xmreg::install_stop_handlers();
+    };
+
+    // the scan was stopped by ctrl+c, or at
+    // a block which could not be read
+    auto scan_interrupted = [&](bool completed)
+    {
+        if (completed)
+        {
+            return false;
+        }
+
+        cerr << (xmreg::stop_requested() ? "\nScan interrupted" : "\nScan failed");
+
+        if (checkpoint)
+        {
+            cerr << ", progress saved in " << checkpoint->file_path();
+        }
+
+        cerr << endl;
 
-    crypto::hash8 encrypted_payment_id;
+        return true;
+    };
 
-    if (xmreg::get_encrypted_payment_id(tx, encrypted_payment_id))
+
+    if (verify_blocks_mode)
     {
-        print("\nPayment id (encrypted): {:s}\n", encrypted_payment_id);
+        print("\nVerifying ring signatures in blocks {:d}-{:d}\n", from_height, to_height);
+
+        // stop on ctrl+c, and show what was verified so far
+        xmreg::install_stop_handlers();
+
+        auto start_time = chrono::steady_clock::now();
+
+        xmreg::range_verification summary;
+
+        bool completed = xmreg::verify_range(mcore, from_height, to_height,
+                                             summary, thread_no);
+
+        double verify_time = chrono::duration<double>(
+                chrono::steady_clock::now() - start_time).count();
+
+        for (const xmreg::failed_input& failed: summary.failed)
+        {
+            print_colored(Color::RED, "Failed: ");
+            print("block {:d}, tx {}, input {:d}{}\n",
+                  failed.blk_height, failed.tx_hash, failed.result.in_i,
+                  failed.result.error.empty() ? "" : ", " + failed.result.error);
+        }
+
+        if (summary.read_failed)
+        {
+            print_colored(Color::RED, "Failed: ");
+            print("cant read block {:d}, verification stopped\n",
+                  summary.unreadable_height);
+        }
 
+        print("\n{}Txs: {:d}, signatures: {:d}, ring members: {:d}, failed: {:d}\n",
+              completed ? "" : (summary.read_failed ? "Incomplete. " : "Interrupted. "),
+              summary.tx_no, summary.signature_no,
+              summary.ring_member_no, summary.failed.size());
+
+        print("Verified in {:0.1f} s, {:0.0f} signatures/s, {:0.0f} ring members/s\n",
+              verify_time,
+              summary.signature_no / max(verify_time, 1e-9),
+              summary.ring_member_no / max(verify_time, 1e-9));
+
+        cout << "\nEnd of program." << endl;
+
+        return summary.failed.empty() && completed ? 0 : 1;
     }
-    else
+
+
+    if (build_ring_cache_opt)
     {
-        crypto::hash payment_id;
+        print("\nExtracting rings of blocks {:d}-{:d}\n", from_height, to_height);
 
-        if (xmreg::get_payment_id(tx, payment_id))
+        auto start_time = chrono::steady_clock::now();
+
+        if (!xmreg::RingCache::build(mcore, from_height, to_height,
+                                     *build_ring_cache_opt, thread_no))
         {
-            print("\nPayment id: {:s}\n", payment_id);
+            cerr << "Cant build ring cache." << endl;
+            return 1;
         }
-        else
+
+        double build_time = chrono::duration<double>(
+                chrono::steady_clock::now() - start_time).count();
+
+        print("Extracted in {:0.1f} s and saved in {}\n", build_time, *build_ring_cache_opt);
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
+
+
+    // rings for chain-wide passes are read from the ring
+    // cache, if given, or from the blockchain
+    unique_ptr<xmreg::RingSource> ring_source;
+
+    if (ring_cache_opt)
+    {
+        xmreg::RingCache* ring_cache = new xmreg::RingCache;
+
+        ring_source.reset(ring_cache);
+
+        if (!ring_cache->load(*ring_cache_opt))
         {
-            print("\nPayment id: not present\n");
+            cerr << "Cant load ring cache: " << *ring_cache_opt << endl;
+            return 1;
         }
+
+        ring_cache->select(from_height, to_height);
+    }
+    else
+    {
+        ring_source.reset(new xmreg::ChainRingSource {mcore, from_height, to_height});
     }
 
-    // get block height in which the given transaction is located
-    uint64_t tx_blk_height = core_storage.get_db().get_tx_block_height(tx_hash);
 
-    print("\ntx hash          : {}, block height {}\n\n", tx_hash, tx_blk_height);
+    if (build_ring_graph_opt)
+    {
+        print("\nBuilding ring graph of blocks {:d}-{:d}\n",
+              ring_source->from_height(), ring_source->to_height());
+
+        auto start_time = chrono::steady_clock::now();
 
-    if (VIEWKEY_AND_ADDRESS_GIVEN)
+        xmreg::RingGraph ring_graph;
+
+        if (!ring_graph.build(*ring_source, thread_no)
+            || !ring_graph.save(*build_ring_graph_opt))
+        {
+            cerr << "Cant build ring graph." << endl;
+            return 1;
+        }
+
+        double build_time = chrono::duration<double>(
+                chrono::steady_clock::now() - start_time).count();
+
+        print("Inputs: {:d}, outputs: {:d}, ring members: {:d}\n",
+              ring_graph.input_no(), ring_graph.output_no(), ring_graph.edge_no());
+
+        print("Built in {:0.1f} s and saved in {}\n", build_time, *build_ring_graph_opt);
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
+
+
+    if (build_decoy_counts_opt)
     {
-        // lets check our keys
-        print("private view key : {}\n", private_view_key);
-        print("address          : {}\n\n\n", xmreg::print_address(address, testnet));
+        print("\nCounting ring members in blocks {:d}-{:d}\n",
+              ring_source->from_height(), ring_source->to_height());
+
+        auto start_time = chrono::steady_clock::now();
+
+        xmreg::DecoyCounter decoy_counter;
+
+        if (!decoy_counter.build(*ring_source, thread_no)
+            || !decoy_counter.save(*build_decoy_counts_opt))
+        {
+            cerr << "Cant count ring members." << endl;
+            return 1;
+        }
+
+        double build_time = chrono::duration<double>(
+                chrono::steady_clock::now() - start_time).count();
+
+        print("Amounts: {:d}\n", decoy_counter.amount_no());
+
+        print("Counted in {:0.1f} s and saved in {}\n", build_time, *build_decoy_counts_opt);
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
     }
 
-    time_t server_timestamp {std::time(nullptr)};
 
-    vector<string> mixin_timescales_str;
+    if (build_keyimage_index_opt)
+    {
+        print("\nIndexing key images of blocks {:d}-{:d}\n", from_height, to_height);
+
+        // stop on ctrl+c
+        xmreg::install_stop_handlers();
+
+        auto start_time = chrono::steady_clock::now();
+
+        xmreg::KeyImageIndex keyimage_index;
+
+        if (!keyimage_index.build(mcore, from_height, to_height, thread_no)
+            || !keyimage_index.save(*build_keyimage_index_opt))
+        {
+            cerr << "Cant build key image index." << endl;
+            return 1;
+        }
+
+        double build_time = chrono::duration<double>(
+                chrono::steady_clock::now() - start_time).count();
+
+        print("Key images: {:d}\n", keyimage_index.key_image_no());
+
+        print("Indexed in {:0.1f} s and saved in {}\n", build_time, *build_keyimage_index_opt);
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
 
-    // total number of inputs in the transaction tx
-    size_t input_no = tx.vin.size();
 
-    for (size_t in_i = 0; in_i < input_no; ++in_i)
+    if (build_payment_id_index_opt)
     {
-        cryptonote::txin_v tx_in = tx.vin[in_i];
+        print("\nIndexing payment ids of blocks {:d}-{:d}\n", from_height, to_height);
+
+        // stop on ctrl+c
+        xmreg::install_stop_handlers();
+
+        auto start_time = chrono::steady_clock::now();
+
+        xmreg::PaymentIdIndex payment_id_index;
 
-        if (tx_in.type() == typeid(cryptonote::txin_gen))
+        if (!payment_id_index.build(mcore, from_height, to_height, thread_no)
+            || !payment_id_index.save(*build_payment_id_index_opt))
         {
-            print(" - coinbase tx: no inputs here.\n");
-            continue;
+            cerr << "Cant build payment id index." << endl;
+            return 1;
         }
 
-        // get tx input key
-        const cryptonote::txin_to_key& tx_in_to_key
-                = boost::get<cryptonote::txin_to_key>(tx_in);
+        double build_time = chrono::duration<double>(
+                chrono::steady_clock::now() - start_time).count();
+
+        print("Txs with payment ids: {:d}\n", payment_id_index.tx_no());
 
+        print("Indexed in {:0.1f} s and saved in {}\n", build_time, *build_payment_id_index_opt);
 
-        print("Input's key image: {}, xmr: {:0.8f}\n",
-              tx_in_to_key.k_image,
-              xmreg::get_xmr(tx_in_to_key.amount));
+        cout << "\nEnd of program." << endl;
 
-        // get absolute offsets of mixins
-        std::vector<uint64_t> absolute_offsets
-                = cryptonote::relative_output_offsets_to_absolute(
-                        tx_in_to_key.key_offsets);
+        return 0;
+    }
 
-        std::vector<cryptonote::output_data_t> outputs;
-        core_storage.get_db().get_output_key(tx_in_to_key.amount,
-                                             absolute_offsets,
-                                             outputs);
 
-        vector<uint64_t> mixin_timestamps;
+    // show txs with the given payment ids
+    if (payment_id_opt)
+    {
+        if (!payment_id_index_opt)
+        {
+            cerr << "Payment id index not given: use --payment-id-index" << endl;
+            return 1;
+        }
 
-        size_t count = 0;
+        xmreg::PaymentIdIndex payment_id_index;
 
-        for (const uint64_t& i: absolute_offsets)
+        if (!payment_id_index.load(*payment_id_index_opt))
         {
+            cerr << "Cant load payment id index: " << *payment_id_index_opt << endl;
+            return 1;
+        }
 
-            cryptonote::output_data_t output_data;
+        for (const string& payment_id_str: *payment_id_opt)
+        {
+            crypto::hash  payment_id;
+            crypto::hash8 encrypted_payment_id;
 
-            bool output_at {true};
+            xmreg::array_view<xmreg::payment_id_tx> id_txs;
 
-            // get tx hash and output index for output
-            if (count < outputs.size())
+            // kind of payment id is given by its length
+            if (payment_id_str.size() == 2 * sizeof(payment_id)
+                && xmreg::hex_decode(payment_id_str.data(), payment_id_str.size(), &payment_id))
+            {
+                id_txs = payment_id_index.find(payment_id);
+            }
+            else if (payment_id_str.size() == 2 * sizeof(encrypted_payment_id)
+                     && xmreg::hex_decode(payment_id_str.data(), payment_id_str.size(),
+                                          &encrypted_payment_id))
+            {
+                id_txs = payment_id_index.find(encrypted_payment_id);
+            }
+            else
             {
-                output_data = outputs.at(count);
+                cerr << "Cant parse payment id: " << payment_id_str << endl;
+                return 1;
             }
 
-           // find tx_hash with given output
-            crypto::hash tx_hash;
-            cryptonote::transaction tx_found;
+            print("\nPayment id {}: {:d} txs in blocks {:d}-{:d}\n\n", payment_id_str,
+                  id_txs.size(), payment_id_index.from_height(), payment_id_index.to_height());
 
-            if (!mcore.get_tx_hash_from_output_pubkey(
-                    output_data.pubkey,
-                    output_data.height,
-                    tx_hash, tx_found))
+            for (const xmreg::payment_id_tx& id_tx: id_txs)
             {
-                print("- cant find tx_hash for ouput: {}, mixin no: {}, blk: {}\n",
-                      output_data.pubkey, count + 1, output_data.height);
-
-                continue;
+                print(" - block {:d}, {}, tx {}\n", id_tx.blk_height,
+                      xmreg::timestamp_to_str(mcore.get_blk_timestamp(id_tx.blk_height)),
+                      id_tx.tx_hash);
             }
+        }
 
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
 
-            // find output in a given transaction
-            // basted on its public key
-            cryptonote::tx_out found_output;
-            size_t output_index;
 
-            if (!mcore.find_output_in_tx(tx_found,
-                                         output_data.pubkey,
-                                         found_output,
-                                         output_index))
-            {
-                print("- cant find tx_out for ouput: {}, mixin no: {}, blk: {}\n",
-                      output_data.pubkey, count + 1, output_data.height);
+    if (key_images_mode)
+    {
+        print("\nSearching our outputs in blocks {:d}-{:d}\n", from_height, to_height);
 
-                continue;
-            }
+        open_checkpoint(fmt::format("key-images {} {:d}", *address_opt, from_height));
 
+        vector<xmreg::transfer_details> belonging_outputs;
 
-            // get block of given height, as we want to get its timestamp
-            cryptonote::block blk;
+        bool completed = xmreg::find_belonging_outputs(mcore, from_height, to_height,
+                                                       private_view_key,
+                                                       address.m_spend_public_key,
+                                                       belonging_outputs,
+                                                       checkpoint.get());
 
-            if (!mcore.get_block_by_height(output_data.height, blk))
-            {
-                print("- cant get block of height: {}\n", output_data.height);
-                continue;
-            }
+        if (scan_interrupted(completed))
+        {
+            return 1;
+        }
 
-            // get mixin block timestamp
-            uint64_t blk_timestamp = blk.timestamp;
+        vector<xmreg::owned_output_status> owned_outputs;
 
-            // calculate time difference bewteen mixing block and current blockchain height
-            array<size_t, 5> time_diff;
-            time_diff = xmreg::timestamp_difference(current_blk_timestamp, blk_timestamp);
+        for (const xmreg::transfer_details& td: belonging_outputs)
+        {
+            xmreg::owned_output_status out;
+            out.td = td;
+            owned_outputs.push_back(out);
+        }
 
-            // save mixin timestamp for later
-            mixin_timestamps.push_back(blk_timestamp);
+        xmreg::generate_key_images(owned_outputs,
+                                   private_view_key,
+                                   private_spend_key,
+                                   address.m_spend_public_key,
+                                   thread_no);
 
-            print("\n - mixin no: {}, block height: {}, timestamp: {}, "
-                          "time_diff: {} y, {} d, {} h, {} m, {} s",
-                  count + 1, output_data.height,
-                  xmreg::timestamp_to_str(blk_timestamp),
-                  time_diff[0], time_diff[1], time_diff[2], time_diff[3], time_diff[4]);
+        size_t spent_no = xmreg::check_key_images_spent(mcore, owned_outputs, thread_no);
 
-            bool is_ours {false};
+        if (!xmreg::find_spending_txs(mcore, owned_outputs, height))
+        {
+            cerr << "Cant find all spending transactions." << endl;
+        }
 
+        uint64_t unspent_amount {0};
 
-            // get global transaction index in the blockchain
-            vector<uint64_t> out_global_indeces;
+        for (const xmreg::owned_output_status& out: owned_outputs)
+        {
+            print("\n{}\n", out.td);
 
-            if (!core_storage.get_tx_outputs_gindexs(
-                    cryptonote::get_transaction_hash(tx_found),
-                    out_global_indeces))
+            if (!out.key_image_ok)
             {
-                print("- cant find global indices for tx: {}\n", tx_hash);
-
+                print(" - cant generate key image\n");
                 continue;
             }
 
-            // get the global index for the current output
-            uint64_t global_out_idx = {0};
+            print(" - key image: {}, spent: ", out.k_image);
+            print_colored(out.spent ? Color::RED : Color::GREEN, "{}", out.spent);
 
-            if (output_index < out_global_indeces.size())
+            if (out.spent)
             {
-                global_out_idx = out_global_indeces[output_index];
+                print(" in tx {}, block height {}",
+                      out.spending_tx_hash, out.spending_blk_height);
             }
-
-
-            if (VIEWKEY_AND_ADDRESS_GIVEN)
+            else
             {
-                // check if the given mixin's output is ours based
-                // on the view key and public spend key from the address
-                is_ours = xmreg::is_output_ours(output_index, tx_found,
-                                                private_view_key,
-                                                address.m_spend_public_key);
-
-                Color c  = is_ours ? Color::GREEN : Color::RED;
-
-                print(", ours: "); print_colored(c, "{}", is_ours);
+                unspent_amount += out.td.amount();
             }
 
-            // get tx public key from extras field
-            crypto::public_key pub_tx_key = cryptonote::get_tx_pub_key_from_extra(tx_found);
-
-            print("\n"
-                  "  - output's pubkey: {}\n", output_data.pubkey);
+            print("\n");
+        }
 
-            print("  - in tx with hash: {}\n", tx_hash);
+        print("\nOutputs found: {:d}, spent: {:d}, unspent: {:d}, unspent xmr: {:0.8f}\n",
+              owned_outputs.size(), spent_no, owned_outputs.size() - spent_no,
+              xmreg::get_xmr(unspent_amount));
 
-            print("  - this tx pub key: {}\n", pub_tx_key);
+        cout << "\nEnd of program." << endl;
 
-            print("  - out_i: {:03d}, g_idx: {:d}, xmr: {:0.8f}\n",
-                  output_index, global_out_idx, xmreg::get_xmr(found_output.amount));
+        return 0;
+    }
 
-            ++count;
-        } // for (const uint64_t& i: absolute_offsets)
 
+    if (spend_ages_mode)
+    {
+        print("\nSearching our outputs in blocks {:d}-{:d}\n", from_height, to_height);
 
-        // get mixins in time scale for visual representation
-        string mixin_times_scale = xmreg::timestamps_time_scale(mixin_timestamps,
-                                                                server_timestamp);
+        open_checkpoint(fmt::format("spend-ages {} {:d}", *address_opt, from_height));
 
-        // save the string timescales for later to show
-        mixin_timescales_str.push_back(mixin_times_scale);
+        vector<xmreg::transfer_details> belonging_outputs;
 
-        print("\nRing signature for the above input, i.e.,: key image {}, xmr: {:0.8f}: \n\n",
-              tx_in_to_key.k_image, xmreg::get_xmr(tx_in_to_key.amount));
+        bool completed = xmreg::find_belonging_outputs(mcore, from_height, to_height,
+                                                       private_view_key,
+                                                       address.m_spend_public_key,
+                                                       belonging_outputs,
+                                                       checkpoint.get());
 
-        for (const crypto::signature &sig: tx.signatures[in_i])
+        if (scan_interrupted(completed))
         {
-            cout << " - " << xmreg::print_sig(sig) << endl;
+            return 1;
         }
 
-        cout << endl;
+        vector<uint64_t> global_indices;
 
-    } // for (size_t in_i = 0; in_i < input_no; ++in_i)
+        if (!xmreg::get_global_indices(mcore, belonging_outputs, global_indices))
+        {
+            return 1;
+        }
 
-    print("\nMixin timescales for this transaction: \n\n");
+        vector<xmreg::owned_output_status> owned_outputs(belonging_outputs.size());
 
-    for (const string& mixin_times_scale: mixin_timescales_str)
-    {
-        cout << "Genesis <" << mixin_times_scale
-             << ">" << " " << xmreg::timestamp_to_str(server_timestamp, "%F")
+        for (size_t i = 0; i < belonging_outputs.size(); ++i)
+        {
+            owned_outputs[i].td = belonging_outputs[i];
+        }
+
+        xmreg::generate_key_images(owned_outputs,
+                                   private_view_key,
+                                   private_spend_key,
+                                   address.m_spend_public_key,
+                                   thread_no);
+
+        xmreg::check_key_images_spent(mcore, owned_outputs, thread_no);
+
+        if (!xmreg::find_spending_txs(mcore, owned_outputs, height))
+        {
+            cerr << "Cant find all spending transactions." << endl;
+        }
+
+        vector<xmreg::real_spend> spends
+                = xmreg::find_real_spends(mcore, owned_outputs, global_indices, thread_no);
+
+        // one line per real spend
+        print("\n{:>8s} {:64s} {:>3s} {:>4s} {:>4s} {:>8s} {:>8s}\n",
+              "height", "tx hash", "in", "ring", "rank", "blocks", "days");
+
+        for (const xmreg::real_spend& spend: spends)
+        {
+            if (!spend.found)
+            {
+                cerr << "Cant find input spending output of tx "
+                     << owned_outputs[spend.output_idx].td.tx_hash() << endl;
+                continue;
+            }
+
+            print("{:8d} {:64s} {:3d} {:4d} {:4d} {:8d} {:8.1f}\n",
+                  spend.blk_height, xmreg::pod_to_hex(spend.tx_hash),
+                  spend.in_i, spend.ring_size, spend.rank,
+                  spend.age_blocks, spend.age_seconds / 86400.0);
+        }
+
+        xmreg::spend_age_stats stats = xmreg::get_spend_age_stats(spends);
+
+        print("\nReal spends: {:d}, median age: {:d} blocks, mean age: {:0.1f} blocks\n",
+              stats.spend_no, stats.median_age_blocks, stats.mean_age_blocks);
+
+        if (stats.spend_no > 0)
+        {
+            print("Newest ring member: {:d} ({:0.1f}%), oldest ring member: {:d} ({:0.1f}%)\n",
+                  stats.newest_no, 100.0 * stats.newest_no / stats.spend_no,
+                  stats.oldest_no, 100.0 * stats.oldest_no / stats.spend_no);
+
+            print("\nRank in ring, from the newest member:\n\n");
+
+            for (size_t rank = 0; rank < stats.rank_counts.size(); ++rank)
+            {
+                print(" - {:2d}: {:d} ({:0.1f}%)\n", rank, stats.rank_counts[rank],
+                      100.0 * stats.rank_counts[rank] / stats.spend_no);
+            }
+
+            print("\nAge when spent:\n\n");
+
+            for (size_t i = 0; i < stats.age_counts.size(); ++i)
+            {
+                print(" - {:>9s}: {:d} ({:0.1f}%)\n", xmreg::age_bucket_name(i),
+                      stats.age_counts[i], 100.0 * stats.age_counts[i] / stats.spend_no);
+            }
+        }
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
+
+
+    if (decoy_exposure_mode)
+    {
+        print("\nSearching our outputs in blocks {:d}-{:d}\n", from_height, to_height);
+
+        open_checkpoint(fmt::format("decoy-exposure {} {:d}", *address_opt, from_height));
+
+        vector<xmreg::transfer_details> belonging_outputs;
+
+        bool completed = xmreg::find_belonging_outputs(mcore, from_height, to_height,
+                                                       private_view_key,
+                                                       address.m_spend_public_key,
+                                                       belonging_outputs,
+                                                       checkpoint.get());
+
+        if (scan_interrupted(completed))
+        {
+            return 1;
+        }
+
+        vector<uint64_t> global_indices;
+
+        if (!xmreg::get_global_indices(mcore, belonging_outputs, global_indices))
+        {
+            return 1;
+        }
+
+        // with the spend key, our key images show
+        // which rings really spend our outputs
+        vector<xmreg::owned_output_status> owned_outputs(belonging_outputs.size());
+
+        for (size_t i = 0; i < belonging_outputs.size(); ++i)
+        {
+            owned_outputs[i].td = belonging_outputs[i];
+        }
+
+        if (spendkey_opt)
+        {
+            xmreg::generate_key_images(owned_outputs,
+                                       private_view_key,
+                                       private_spend_key,
+                                       address.m_spend_public_key,
+                                       thread_no);
+        }
+
+        print("Searching rings using our {:d} outputs in blocks {:d}-{:d}\n",
+              belonging_outputs.size(),
+              ring_source->from_height(), ring_source->to_height());
+
+        // stop on ctrl+c
+        xmreg::install_stop_handlers();
+
+        vector<xmreg::output_ring_use> ring_uses;
+
+        if (!xmreg::find_output_ring_uses(*ring_source, belonging_outputs,
+                                          global_indices, ring_uses, thread_no))
+        {
+            // rings of unreadable blocks would be silently missing
+            if (!xmreg::stop_requested())
+            {
+                cerr << "\nCant read all rings, search failed." << endl;
+                return 1;
+            }
+
+            cerr << "\nSearch interrupted, showing rings found so far" << endl;
+        }
+
+        // rings of each output, in height order
+        vector<vector<const xmreg::output_ring_use*>> output_rings(belonging_outputs.size());
+
+        for (const xmreg::output_ring_use& ring_use: ring_uses)
+        {
+            output_rings[ring_use.output_idx].push_back(&ring_use);
+        }
+
+        size_t exposed_no {0};
+        size_t decoy_use_no {0};
+
+        for (size_t i = 0; i < belonging_outputs.size(); ++i)
+        {
+            const xmreg::owned_output_status& out = owned_outputs[i];
+
+            size_t decoy_no {0};
+
+            print("\n{}, g_idx: {:d}\n", out.td, global_indices[i]);
+
+            for (const xmreg::output_ring_use* ring_use: output_rings[i])
+            {
+                bool is_spend = out.key_image_ok && ring_use->k_image == out.k_image;
+
+                print(" - block {:d}, {}, ",
+                      ring_use->blk_height,
+                      xmreg::timestamp_to_str(mcore.get_blk_timestamp(ring_use->blk_height)));
+
+                if (ring_use->tx_hash != crypto::null_hash)
+                {
+                    print("tx {}, input {:d}, ", ring_use->tx_hash, ring_use->in_i);
+                }
+
+                print("key image {}, ring size {:d}",
+                      ring_use->k_image, ring_use->ring_size);
+
+                if (is_spend)
+                {
+                    print(", "); print_colored(Color::GREEN, "our spend");
+                }
+                else
+                {
+                    ++decoy_no;
+                }
+
+                print("\n");
+            }
+
+            print(" - used as decoy in {:d} rings\n", decoy_no);
+
+            exposed_no   += decoy_no > 0;
+            decoy_use_no += decoy_no;
+        }
+
+        print("\nOutputs found: {:d}, used as decoys: {:d}, decoy uses: {:d}\n",
+              belonging_outputs.size(), exposed_no, decoy_use_no);
+
+        if (!spendkey_opt)
+        {
+            print("No spendkey given, so rings spending our outputs "
+                  "are counted as decoy uses as well\n");
+        }
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
+
+
+    if (scan_outputs_mode)
+    {
+        print("\nSearching outputs in blocks {:d}-{:d}\n\n", from_height, to_height);
+
+        if (VIEWKEY_AND_ADDRESS_GIVEN)
+        {
+            // the address given with --address is checked
+            // along other accounts
+            accounts.add_account(*address_opt, *viewkey_opt, testnet);
+        }
+
+        open_checkpoint(fmt::format("scan-outputs {} {} {:d}",
+                                    accounts_file_opt ? *accounts_file_opt : "",
+                                    address_opt ? *address_opt : "",
+                                    from_height));
+
+        vector<xmreg::account_transfer> found_outputs;
+
+        bool completed = xmreg::find_accounts_outputs(mcore, from_height, to_height,
+                                                      accounts, found_outputs,
+                                                      checkpoint.get());
+
+        if (scan_interrupted(completed))
+        {
+            return 1;
+        }
+
+        vector<uint64_t> account_totals(accounts.size(), 0);
+
+        for (const xmreg::account_transfer& out: found_outputs)
+        {
+            print("{} - {}\n",
+                  accounts[out.account_idx].address_str.substr(0, 8),
+                  out.td);
+
+            account_totals[out.account_idx] += out.td.amount();
+        }
+
+        print("\nReceived xmr per account:\n\n");
+
+        for (size_t acc_i = 0; acc_i < accounts.size(); ++acc_i)
+        {
+            print(" - {}: {:0.8f}\n",
+                  accounts[acc_i].address_str,
+                  xmreg::get_xmr(account_totals[acc_i]));
+        }
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
+
+
+    // resolves rings of inputs, and checks who owns their mixins
+    xmreg::RingAnalyzer analyzer {mcore, scanner.get(),
+                                  accounts.empty() ? nullptr : &accounts};
+
+
+    if (follow_mode)
+    {
+        // without explicit start, only blocks added from now on are processed
+        uint64_t start_height = (from_height_opt || from_date_opt) ? from_height : height + 1;
+
+        print("\nFollowing the blockchain from block {:d}\n", start_height);
+
+        // finish on ctrl+c
+        xmreg::install_stop_handlers();
+
+        xmreg::ChainFollower follower {mcore, start_height, reorg_depth};
+
+        // reused by lookups of all inputs
+        xmreg::analysis_scratch scratch;
+
+        auto process_block = [&](uint64_t blk_height,
+                                 const cryptonote::block& blk,
+                                 const list<cryptonote::transaction>& txs)
+        {
+            print("\nBlock {:d}, time: {}, txs: {:d}\n",
+                  blk_height, xmreg::timestamp_to_str(blk.timestamp), txs.size() - 1);
+
+            for (const cryptonote::transaction& tx: txs)
+            {
+                crypto::hash tx_hash = cryptonote::get_transaction_hash(tx);
+
+                // outputs received by us, or by the accounts
+                if (scanner)
+                {
+                    for (const xmreg::transfer_details& td:
+                            xmreg::get_belonging_outputs(blk, tx, *scanner, blk_height))
+                    {
+                        print(" - received: ");
+                        print_colored(Color::GREEN, "{}\n", td);
+                    }
+                }
+
+                for (const xmreg::account_output& out: accounts.get_belonging_outputs(tx))
+                {
+                    print(" - received by {}: ", accounts[out.account_idx].address_str);
+                    print_colored(Color::GREEN, "tx {}, out idx {}, xmr: {:0.8f}\n",
+                                  tx_hash, out.output_index,
+                                  xmreg::get_xmr(tx.vout[out.output_index].amount));
+                }
+
+                if (tx.vin.empty() || tx.vin[0].type() == typeid(cryptonote::txin_gen))
+                {
+                    continue;
+                }
+
+                print(" tx {}, inputs: {:d}, outputs: {:d}\n",
+                      tx_hash, tx.vin.size(), tx.vout.size());
+
+                for (size_t in_i = 0; in_i < tx.vin.size(); ++in_i)
+                {
+                    xmreg::input_details in_details;
+
+                    // e.g., a missing output throws, and would do so again
+                    // on each retry of the block, so only this input is skipped
+                    try
+                    {
+                        if (!analyzer.analyze_input(tx, in_i, in_details, &scratch))
+                        {
+                            continue;
+                        }
+                    }
+                    catch (const std::exception& e)
+                    {
+                        print("  - input {:d}: ", in_i);
+                        print_colored(Color::RED, "cant analyze: {}\n", e.what());
+                        continue;
+                    }
+
+                    print("  - key image: {}, xmr: {:0.8f}, ring size: {:d}, mixin blocks:",
+                          in_details.k_image, xmreg::get_xmr(in_details.amount),
+                          in_details.mixins.size());
+
+                    for (const xmreg::mixin_details& mixin: in_details.mixins)
+                    {
+                        if (mixin.is_ours || !mixin.owners.empty())
+                        {
+                            print_colored(Color::GREEN, " {:d}*", mixin.block_height);
+                        }
+                        else
+                        {
+                            print(" {:d}", mixin.block_height);
+                        }
+                    }
+
+                    print("\n");
+                }
+            }
+
+            // emit results as soon as the block is processed
+            fflush(stdout);
+        };
+
+        auto on_rollback = [&](uint64_t common_height)
+        {
+            print_colored(Color::YELLOW,
+                          "\nBlockchain reorganized, rolling back to block {:d}\n",
+                          common_height);
+        };
+
+        follower.run(poll_interval_ms, process_block, on_rollback);
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
+
+
+    if (verify_mode)
+    {
+        size_t failed_no {0};
+
+        for (const crypto::hash& tx_hash: tx_hashes)
+        {
+            cryptonote::transaction tx;
+            xmreg::tx_header_details hdr;
+
+            if (!analyzer.analyze_header(tx_hash, tx, hdr))
+            {
+                ++failed_no;
+                continue;
+            }
+
+            print("\ntx hash: {}, block height {}\n\n", tx_hash, hdr.blk_height);
+
+            for (const xmreg::input_verification& result:
+                    xmreg::verify_tx(mcore, tx, thread_no))
+            {
+                if (result.is_coinbase)
+                {
+                    print(" - coinbase tx: no inputs here.\n");
+                    continue;
+                }
+
+                const cryptonote::txin_to_key& tx_in_to_key
+                        = boost::get<cryptonote::txin_to_key>(tx.vin[result.in_i]);
+
+                print(" - input {:d}, key image: {}, ring size: {:d}, signature: ",
+                      result.in_i, tx_in_to_key.k_image, tx_in_to_key.key_offsets.size());
+
+                if (result.valid)
+                {
+                    print_colored(Color::GREEN, "valid\n");
+                }
+                else
+                {
+                    print_colored(Color::RED, "INVALID");
+                    print("{}\n", result.error.empty() ? "" : " (" + result.error + ")");
+                    ++failed_no;
+                }
+            }
+        }
+
+        cout << "\nEnd of program." << endl;
+
+        return failed_no == 0 ? 0 : 1;
+    }
+
+
+    time_t server_timestamp {std::time(nullptr)};
+
+
+    // ring graph, if given, to find ring members
+    // that are provably decoys
+    xmreg::RingGraph ring_graph;
+    unique_ptr<xmreg::ZeroMixinCascade> cascade;
+
+    if (ring_graph_opt)
+    {
+        if (!ring_graph.load(*ring_graph_opt))
+        {
+            cerr << "Cant load ring graph: " << *ring_graph_opt << endl;
+            return 1;
+        }
+
+        auto start_time = chrono::steady_clock::now();
+
+        ring_graph.build_reverse();
+
+        cascade.reset(new xmreg::ZeroMixinCascade {ring_graph});
+        cascade->run();
+
+        double cascade_time = chrono::duration<double>(
+                chrono::steady_clock::now() - start_time).count();
+
+        print("\nRing graph of blocks {:d}-{:d}: real outputs found for "
+              "{:d} of {:d} inputs in {:0.1f} s\n",
+              ring_graph.from_height(), ring_graph.to_height(),
+              cascade->deduced_no(), ring_graph.input_no(), cascade_time);
+    }
+
+
+    // how many times each output was used as a ring member, if given
+    xmreg::DecoyCounter decoy_counter;
+
+    if (decoy_counts_opt && !decoy_counter.load(*decoy_counts_opt))
+    {
+        cerr << "Cant load decoy counts: " << *decoy_counts_opt << endl;
+        return 1;
+    }
+
+
+    xmreg::RingPrinter printer {current_blk_timestamp, server_timestamp};
+
+    printer.use_colors(!no_color);
+
+    if (VIEWKEY_AND_ADDRESS_GIVEN)
+    {
+        printer.show_keys(private_view_key, address, testnet);
+    }
+
+    if (!accounts.empty())
+    {
+        printer.show_owners(accounts);
+    }
+
+    if (cascade)
+    {
+        printer.show_cascade(ring_graph, *cascade);
+    }
+
+    if (decoy_counts_opt)
+    {
+        printer.show_decoy_counts(decoy_counter);
+    }
+
+
+    // show inputs which spent the given key images,
+    // instead of whole txs
+    if (keyimage_opt)
+    {
+        xmreg::KeyImageIndex keyimage_index;
+
+        if (!keyimage_index.load(*keyimage_index_opt))
+        {
+            cerr << "Cant load key image index: " << *keyimage_index_opt << endl;
+            return 1;
+        }
+
+        for (const crypto::key_image& k_image: key_images)
+        {
+            xmreg::key_image_spend spend;
+
+            if (!keyimage_index.find(k_image, spend))
+            {
+                print("\nKey image {} not spent in blocks {:d}-{:d}\n", k_image,
+                      keyimage_index.from_height(), keyimage_index.to_height());
+                continue;
+            }
+
+            cryptonote::transaction tx;
+            xmreg::tx_header_details hdr;
+            xmreg::input_details in_details;
+
+            if (!analyzer.analyze_header(spend.tx_hash, tx, hdr)
+                || !analyzer.analyze_input(tx, spend.in_i, in_details))
+            {
+                continue;
+            }
+
+            printer.print_header(hdr);
+            printer.print_input(in_details);
+            printer.print_footer();
+        }
+
+        cout << "\nEnd of program." << endl;
+
+        return 0;
+    }
+
+
+    // Transactions are analyzed in the background, by a pool
+    // of threads, at most prefetch_no of them ahead of the one
+    // being printed, so that blocking blockchain reads
+    // overlap with formatting and writing to the stdout.
+    // Results are printed in the order the tx hashes were given,
+    // or, for a block range, in height order.
+    xmreg::AsyncRingAnalyzer async_analyzer {analyzer, thread_no, prefetch_no};
+
+    // Printed results are written to the stdout by their own
+    // thread, so a slow terminal or pipe does not hold up
+    // submitting next txs. What was printed so far goes first.
+    cout.flush();
+    fflush(stdout);
+
+    // a closed pipe, e.g., of head, should fail the writes
+    // with EPIPE, instead of killing the program
+    signal(SIGPIPE, SIG_IGN);
+
+    xmreg::OutputWriter output_writer {STDOUT_FILENO};
+
+    printer.write_to(output_writer);
+
+    // With ring columns or ndjson, results are also kept column
+    // by column. For ndjson, each tx's ring members are written
+    // to the file, instead of being printed.
+    xmreg::RingColumns ring_columns;
+
+    int ndjson_fd {-1};
+    unique_ptr<xmreg::OutputWriter> ndjson_writer;
+    fmt::MemoryWriter ndjson_out;
+
+    if (ndjson_opt)
+    {
+        ndjson_fd = open(ndjson_opt->c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (ndjson_fd < 0)
+        {
+            cerr << "Cant open ndjson file: " << *ndjson_opt << endl;
+            return 1;
+        }
+
+        ndjson_writer.reset(new xmreg::OutputWriter {ndjson_fd});
+    }
+
+    deque<future<xmreg::tx_analysis>> pending_results;
+
+    // growth of the workers' scratch vectors, i.e., times
+    // they had to reallocate, shown for a block range
+    size_t analyzed_tx_no {0};
+    size_t scratch_growth_no {0};
+    size_t scratch_growth_bytes {0};
+    size_t max_tx_growth_no {0};
+
+    // set when a block or a tx could not be analyzed, or the
+    // analysis was stopped, so results are not complete
+    bool analysis_failed {false};
+    bool analysis_interrupted {false};
+
+    auto print_next_result = [&]()
+    {
+        try
+        {
+            xmreg::tx_analysis result = pending_results.front().get();
+
+            ++analyzed_tx_no;
+            scratch_growth_no    += result.scratch_growth_no;
+            scratch_growth_bytes += result.scratch_growth_bytes;
+            max_tx_growth_no      = max(max_tx_growth_no,
+                                        result.scratch_growth_no);
+
+            if (!ring_columns_opt && !ndjson_opt)
+            {
+                printer.print_tx(result);
+            }
+            else
+            {
+                size_t from_tx = ring_columns.tx_no();
+
+                ring_columns.append(result);
+
+                if (ndjson_writer)
+                {
+                    ring_columns.write_ndjson(ndjson_out, from_tx);
+                    ndjson_writer->write(ndjson_out.data(), ndjson_out.size());
+                    ndjson_out.clear();
+                }
+
+                // only the ndjson file needs them, so keep memory flat
+                if (!ring_columns_opt)
+                {
+                    ring_columns.clear();
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            cerr << e.what() << endl;
+            analysis_failed = true;
+        }
+
+        pending_results.pop_front();
+    };
+
+    auto submit_tx = [&](const crypto::hash& tx_hash)
+    {
+        if (pending_results.size() >= max<size_t>(prefetch_no, 1))
+        {
+            print_next_result();
+        }
+
+        pending_results.push_back(async_analyzer.submit(tx_hash));
+    };
+
+    if (analyze_blocks_mode)
+    {
+        string analyzing_msg = fmt::format("\nAnalyzing transactions in blocks {:d}-{:d}\n",
+                                           from_height, to_height);
+
+        output_writer.write(analyzing_msg.data(), analyzing_msg.size());
+
+        // stop on ctrl+c, once already submitted txs are printed
+        xmreg::install_stop_handlers();
+
+        for (uint64_t blk_height = from_height; blk_height <= to_height; ++blk_height)
+        {
+            if (xmreg::stop_requested())
+            {
+                cerr << "\nAnalysis interrupted at block " << blk_height << endl;
+                analysis_interrupted = true;
+                break;
+            }
+
+            cryptonote::block blk;
+
+            if (!mcore.get_block_by_height(blk_height, blk))
+            {
+                cerr << "Cant get block: " << blk_height << endl;
+                analysis_failed = true;
+                break;
+            }
+
+            // miner tx is not in tx_hashes, so coinbase txs are skipped
+            for (const crypto::hash& tx_hash: blk.tx_hashes)
+            {
+                submit_tx(tx_hash);
+            }
+        }
+    }
+    else
+    {
+        for (const crypto::hash& tx_hash: tx_hashes)
+        {
+            submit_tx(tx_hash);
+        }
+    }
+
+    while (!pending_results.empty())
+    {
+        print_next_result();
+    }
+
+    output_writer.close();
+
+    if (output_writer.failed())
+    {
+        return 1;
+    }
+
+    if (ndjson_writer)
+    {
+        ndjson_writer->close();
+
+        bool ndjson_failed = ndjson_writer->failed();
+
+        if (close(ndjson_fd) != 0 || ndjson_failed)
+        {
+            cerr << "Cant write ndjson file: " << *ndjson_opt << endl;
+            return 1;
+        }
+    }
+
+    if (analysis_failed || analysis_interrupted)
+    {
+        // partial results would look like complete ones
+        if (ndjson_opt)
+        {
+            unlink(ndjson_opt->c_str());
+        }
+
+        cerr << (analysis_failed ? "\nAnalysis failed" : "\nAnalysis interrupted")
+             << ", after " << analyzed_tx_no << " txs"
+             << (ring_columns_opt || ndjson_opt ? ", results not saved." : ".")
              << endl;
+
+        return 1;
+    }
+
+    if (ring_columns_opt)
+    {
+        if (!ring_columns.save(*ring_columns_opt))
+        {
+            return 1;
+        }
+
+        xmreg::ring_columns_stats stats = ring_columns.stats(current_blk_timestamp);
+
+        print("\nRing columns saved into: {}\n", *ring_columns_opt);
+        print("Transactions          : {:d}\n", stats.tx_no);
+        print("Inputs                : {:d}\n", stats.input_no);
+        print("Ring members          : {:d}\n", stats.member_no);
+        print("Ours                  : {:d}\n", stats.ours_no);
+        print("Unresolved            : {:d}\n", stats.unresolved_no);
+        print("Block heights         : {:d}-{:d}\n",
+              stats.min_block_height, stats.max_block_height);
+        print("Mean age              : {:0.1f} days\n",
+              stats.mean_age_seconds / (24 * 3600));
+    }
+
+    if (analyze_blocks_mode)
+    {
+        print("\nAnalyzed txs: {:d}, scratch vector growth: {:d} ({:d} bytes), "
+              "at most {:d} in a tx\n",
+              analyzed_tx_no, scratch_growth_no,
+              scratch_growth_bytes, max_tx_growth_no);
     }
 
     cout << "\nEnd of program." << endl;
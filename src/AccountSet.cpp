@@ -0,0 +1,204 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "AccountSet.h"
+
+#include <fstream>
+#include <sstream>
+
+
+namespace xmreg
+{
+
+    /**
+     * Parse address and private view key strings
+     * and add them to the set
+     */
+    bool
+    AccountSet::add_account(const string& address_str,
+                            const string& viewkey_str,
+                            bool testnet)
+    {
+        account_keys acc;
+
+        acc.address_str = address_str;
+
+        if (!parse_str_address(address_str, acc.address, testnet))
+        {
+            return false;
+        }
+
+        if (!parse_str_secret_key(viewkey_str, acc.private_view_key))
+        {
+            return false;
+        }
+
+        m_scanners.emplace_back(acc.private_view_key,
+                                acc.address.m_spend_public_key);
+
+        m_accounts.push_back(acc);
+
+        return true;
+    }
+
+
+    /**
+     * Read accounts from a text file. Each line has
+     * an address and its private view key separated by
+     * white space. Empty lines and lines starting
+     * with # are skipped.
+     */
+    bool
+    AccountSet::load_from_file(const string& file_path, bool testnet)
+    {
+        ifstream in {file_path};
+
+        if (!in)
+        {
+            cerr << "Cant open accounts file: " << file_path << endl;
+            return false;
+        }
+
+        string line;
+        size_t line_no {0};
+
+        while (getline(in, line))
+        {
+            ++line_no;
+
+            istringstream line_ss {line};
+
+            string address_str;
+            string viewkey_str;
+
+            if (!(line_ss >> address_str) || address_str[0] == '#')
+            {
+                continue;
+            }
+
+            if (!(line_ss >> viewkey_str)
+                || !add_account(address_str, viewkey_str, testnet))
+            {
+                cerr << "Incorrect account in line " << line_no
+                     << " of " << file_path << endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    size_t
+    AccountSet::size() const
+    {
+        return m_accounts.size();
+    }
+
+    bool
+    AccountSet::empty() const
+    {
+        return m_accounts.empty();
+    }
+
+    const account_keys&
+    AccountSet::operator[](size_t account_idx) const
+    {
+        return m_accounts[account_idx];
+    }
+
+
+    /**
+     * Get outputs of the given tx that belong to any of the accounts.
+     *
+     * The tx public key and output keys are read only once
+     * and then reused for each account.
+     */
+    vector<account_output>
+    AccountSet::get_belonging_outputs(const transaction& tx) const
+    {
+        vector<account_output> our_outputs;
+
+        // get transaction's public key
+        public_key pub_tx_key = read_tx_pub_key(tx);
+
+        if (pub_tx_key == null_pkey || tx.vout.empty())
+        {
+            return our_outputs;
+        }
+
+        // get public keys of all outputs
+        vector<public_key> out_pubkeys;
+        out_pubkeys.reserve(tx.vout.size());
+
+        for (const tx_out& out: tx.vout)
+        {
+            out_pubkeys.push_back(boost::get<txout_to_key>(out.target).key);
+        }
+
+        for (size_t acc_i = 0; acc_i < m_accounts.size(); ++acc_i)
+        {
+            const OutputScanner& scanner = m_scanners[acc_i];
+
+            key_derivation derivation;
+
+            if (!scanner.generate_derivation(pub_tx_key, derivation))
+            {
+                continue;
+            }
+
+            for (size_t i = 0; i < out_pubkeys.size(); ++i)
+            {
+                if (scanner.is_output_ours(derivation, i, out_pubkeys[i]))
+                {
+                    our_outputs.push_back(account_output {acc_i, i});
+                }
+            }
+        }
+
+        return our_outputs;
+    }
+
+
+    /**
+     * Get indices of accounts that own the given output of a tx.
+     * Normally there is at most one.
+     */
+    vector<size_t>
+    AccountSet::get_output_owners(const transaction& tx,
+                                  size_t output_index) const
+    {
+        vector<size_t> owners;
+
+        public_key pub_tx_key = read_tx_pub_key(tx);
+
+        if (pub_tx_key == null_pkey || output_index >= tx.vout.size())
+        {
+            return owners;
+        }
+
+        const public_key& out_pubkey
+                = boost::get<txout_to_key>(tx.vout[output_index].target).key;
+
+        for (size_t acc_i = 0; acc_i < m_accounts.size(); ++acc_i)
+        {
+            const OutputScanner& scanner = m_scanners[acc_i];
+
+            key_derivation derivation;
+
+            if (!scanner.generate_derivation(pub_tx_key, derivation))
+            {
+                continue;
+            }
+
+            if (scanner.is_output_ours(derivation, output_index, out_pubkey))
+            {
+                owners.push_back(acc_i);
+            }
+        }
+
+        return owners;
+    }
+
+}
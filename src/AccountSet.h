@@ -0,0 +1,91 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_ACCOUNTSET_H
+#define XMREG01_ACCOUNTSET_H
+
+#include "monero_headers.h"
+#include "tx_details.h"
+#include "OutputScanner.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Address and private view key of
+     * a monitored account
+     */
+    struct account_keys
+    {
+        string                 address_str;
+        account_public_address address;
+        secret_key             private_view_key;
+    };
+
+
+    /**
+     * Output of a tx that belongs to one of the accounts
+     */
+    struct account_output
+    {
+        size_t account_idx;
+        size_t output_index;
+    };
+
+
+    /**
+     * Set of accounts which outputs are checked together.
+     *
+     * A tx is decoded once, i.e., its public key and output
+     * keys are read only one time, and then each account
+     * derives its own keys from them. Thus the cost of checking
+     * a tx grows with the number of key derivations, not
+     * with the number of times the tx is loaded and parsed.
+     *
+     * Each account has its OutputScanner, so its spend key
+     * is prepared only once, when the account is added.
+     */
+    class AccountSet
+    {
+        vector<account_keys> m_accounts;
+
+        vector<OutputScanner> m_scanners;
+
+    public:
+
+        bool
+        add_account(const string& address_str,
+                    const string& viewkey_str,
+                    bool testnet = false);
+
+        bool
+        load_from_file(const string& file_path, bool testnet = false);
+
+        size_t
+        size() const;
+
+        bool
+        empty() const;
+
+        const account_keys&
+        operator[](size_t account_idx) const;
+
+        vector<account_output>
+        get_belonging_outputs(const transaction& tx) const;
+
+        vector<size_t>
+        get_output_owners(const transaction& tx,
+                          size_t output_index) const;
+    };
+
+}
+
+#endif //XMREG01_ACCOUNTSET_H
@@ -0,0 +1,230 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "AsyncRingAnalyzer.h"
+#include "parallel.h"
+
+#include <stdexcept>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        string
+        exception_message(exception_ptr error)
+        {
+            try
+            {
+                rethrow_exception(error);
+            }
+            catch (const std::exception& e)
+            {
+                return e.what();
+            }
+            catch (...)
+            {
+                return "unknown exception";
+            }
+        }
+    }
+
+
+    /**
+     * Start worker threads. The analyzer must outlive
+     * this object, and so must its MicroCore.
+     */
+    AsyncRingAnalyzer::AsyncRingAnalyzer(const RingAnalyzer& analyzer,
+                                         size_t thread_no,
+                                         size_t max_in_flight)
+            : m_analyzer {analyzer},
+              m_max_in_flight {max_in_flight > 0 ? max_in_flight : 1},
+              m_queries {m_max_in_flight}
+    {
+        thread_no = get_thread_no(thread_no);
+
+        for (size_t i = 0; i < thread_no; ++i)
+        {
+            m_workers.emplace_back(&AsyncRingAnalyzer::run_worker, this);
+        }
+    }
+
+
+    /**
+     * Analyze tx of the given hash in the background.
+     *
+     * The future throws runtime_error
+     * if the tx was not found.
+     */
+    future<tx_analysis>
+    AsyncRingAnalyzer::submit(const crypto::hash& tx_hash)
+    {
+        query q;
+
+        q.tx_hash = tx_hash;
+
+        future<tx_analysis> result = q.result.get_future();
+
+        enqueue(std::move(q));
+
+        return result;
+    }
+
+
+    /**
+     * Analyze tx of the given hash in the background, and
+     * call the callback with its result, from a worker thread.
+     */
+    void
+    AsyncRingAnalyzer::submit(const crypto::hash& tx_hash,
+                              analysis_callback callback)
+    {
+        query q;
+
+        q.tx_hash  = tx_hash;
+        q.callback = std::move(callback);
+
+        enqueue(std::move(q));
+    }
+
+
+    /**
+     * Wait until all submitted queries are finished
+     */
+    void
+    AsyncRingAnalyzer::wait_all()
+    {
+        unique_lock<mutex> lock {m_in_flight_mutex};
+
+        m_in_flight_changed.wait(lock, [&] { return m_in_flight == 0; });
+    }
+
+
+    size_t
+    AsyncRingAnalyzer::in_flight()
+    {
+        lock_guard<mutex> lock {m_in_flight_mutex};
+
+        return m_in_flight;
+    }
+
+
+    /**
+     * Finish queries already submitted and stop the workers
+     */
+    AsyncRingAnalyzer::~AsyncRingAnalyzer()
+    {
+        m_queries.close();
+
+        for (thread& worker: m_workers)
+        {
+            worker.join();
+        }
+    }
+
+
+    void
+    AsyncRingAnalyzer::enqueue(query&& q)
+    {
+        {
+            unique_lock<mutex> lock {m_in_flight_mutex};
+
+            m_in_flight_changed.wait(lock, [&]
+            {
+                return m_in_flight < m_max_in_flight;
+            });
+
+            ++m_in_flight;
+        }
+
+        m_queries.push(std::move(q));
+    }
+
+
+    /**
+     * Take queries from the queue until it is closed.
+     *
+     * Exceptions of the analysis, e.g., lmdb errors, go to the
+     * future, or are printed and the callback gets found = false,
+     * so they dont end the worker thread. The in-flight slot
+     * of a query is released even if its callback throws.
+     */
+    void
+    AsyncRingAnalyzer::run_worker()
+    {
+        struct in_flight_release
+        {
+            AsyncRingAnalyzer& self;
+
+            ~in_flight_release()
+            {
+                {
+                    lock_guard<mutex> lock {self.m_in_flight_mutex};
+                    --self.m_in_flight;
+                }
+
+                self.m_in_flight_changed.notify_all();
+            }
+        };
+
+        query q;
+
+        // scratch memory of this worker, reused for all its queries
+        analysis_scratch scratch;
+
+        while (m_queries.pop(q))
+        {
+            in_flight_release release {*this};
+
+            tx_analysis result;
+
+            bool found {false};
+
+            exception_ptr error;
+
+            try
+            {
+                found = m_analyzer.analyze(q.tx_hash, result, &scratch);
+            }
+            catch (...)
+            {
+                error = current_exception();
+            }
+
+            if (q.callback)
+            {
+                if (error)
+                {
+                    cerr << "Analysis of tx " << q.tx_hash
+                         << " failed: " << exception_message(error) << endl;
+                }
+
+                try
+                {
+                    q.callback(found && !error, result);
+                }
+                catch (...)
+                {
+                    cerr << "Callback of tx " << q.tx_hash
+                         << " failed: " << exception_message(current_exception()) << endl;
+                }
+            }
+            else if (error)
+            {
+                q.result.set_exception(error);
+            }
+            else if (found)
+            {
+                q.result.set_value(std::move(result));
+            }
+            else
+            {
+                q.result.set_exception(make_exception_ptr(runtime_error(
+                        "Transaction not found: " + epee::string_tools::pod_to_hex(q.tx_hash))));
+            }
+        }
+    }
+
+}
@@ -0,0 +1,103 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_ASYNCRINGANALYZER_H
+#define XMREG01_ASYNCRINGANALYZER_H
+
+#include "RingAnalyzer.h"
+#include "BoundedQueue.h"
+
+#include <future>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Called from a worker thread with the result of a query.
+     * found is false if the tx was not found, or its
+     * analysis failed, e.g., with a database error.
+     */
+    using analysis_callback = function<void(bool found, tx_analysis& result)>;
+
+
+    /**
+     * Runs RingAnalyzer queries on a pool of worker threads,
+     * so that many tx analyses overlap, each one doing its
+     * own lmdb reads. Results are given as futures,
+     * or to callbacks.
+     *
+     * At most max_in_flight queries are submitted and not yet
+     * finished at any time. submit() waits when the limit is
+     * reached, so callers can't run arbitrarily far ahead.
+     *
+     * A query is just a tx hash and where to put its result,
+     * moved through a queue, without extra allocations
+     * apart from the result itself.
+     */
+    class AsyncRingAnalyzer
+    {
+        struct query
+        {
+            crypto::hash          tx_hash;
+            promise<tx_analysis>  result;
+            analysis_callback     callback;
+        };
+
+        const RingAnalyzer& m_analyzer;
+
+        size_t m_max_in_flight;
+
+        BoundedQueue<query> m_queries;
+
+        vector<thread> m_workers;
+
+        // number of submitted and not finished queries
+        size_t m_in_flight {0};
+
+        mutex              m_in_flight_mutex;
+        condition_variable m_in_flight_changed;
+
+    public:
+
+        AsyncRingAnalyzer(const RingAnalyzer& analyzer,
+                          size_t thread_no = 0,
+                          size_t max_in_flight = 64);
+
+        AsyncRingAnalyzer(const AsyncRingAnalyzer&) = delete;
+        AsyncRingAnalyzer& operator=(const AsyncRingAnalyzer&) = delete;
+
+        future<tx_analysis>
+        submit(const crypto::hash& tx_hash);
+
+        void
+        submit(const crypto::hash& tx_hash, analysis_callback callback);
+
+        void
+        wait_all();
+
+        size_t
+        in_flight();
+
+        ~AsyncRingAnalyzer();
+
+    private:
+
+        void
+        enqueue(query&& q);
+
+        void
+        run_worker();
+    };
+
+}
+
+#endif //XMREG01_ASYNCRINGANALYZER_H
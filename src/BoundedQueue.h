@@ -0,0 +1,129 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_BOUNDEDQUEUE_H
+#define XMREG01_BOUNDEDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+
+namespace xmreg
+{
+    using namespace std;
+
+    /**
+     * Fixed capacity, blocking FIFO queue used to connect
+     * two stages of a pipeline running in different threads.
+     *
+     * push() blocks while the queue is full, so the producer
+     * can only run capacity items ahead of the consumer.
+     * pop() blocks while the queue is empty and not closed.
+     *
+     * Once the producer is done, it calls close(). The consumer
+     * then drains what is left, after which pop() returns false.
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+        deque<T> m_items;
+
+        size_t m_capacity;
+
+        bool m_closed {false};
+
+        mutex m_mutex;
+
+        condition_variable m_not_full;
+        condition_variable m_not_empty;
+
+    public:
+
+        explicit BoundedQueue(size_t capacity)
+                : m_capacity {capacity > 0 ? capacity : 1}
+        {}
+
+        /**
+         * Add item to the queue, waiting for free space
+         * if the queue is full.
+         *
+         * returns false if the queue has been closed,
+         * in which case the item is dropped
+         */
+        bool
+        push(T item)
+        {
+            unique_lock<mutex> lock {m_mutex};
+
+            m_not_full.wait(lock, [&]
+            {
+                return m_closed || m_items.size() < m_capacity;
+            });
+
+            if (m_closed)
+            {
+                return false;
+            }
+
+            m_items.push_back(std::move(item));
+
+            lock.unlock();
+
+            m_not_empty.notify_one();
+
+            return true;
+        }
+
+        /**
+         * Take the oldest item from the queue, waiting for
+         * one if the queue is empty.
+         *
+         * returns false when the queue is closed and empty
+         */
+        bool
+        pop(T& item)
+        {
+            unique_lock<mutex> lock {m_mutex};
+
+            m_not_empty.wait(lock, [&]
+            {
+                return m_closed || !m_items.empty();
+            });
+
+            if (m_items.empty())
+            {
+                return false;
+            }
+
+            item = std::move(m_items.front());
+            m_items.pop_front();
+
+            lock.unlock();
+
+            m_not_full.notify_one();
+
+            return true;
+        }
+
+        /**
+         * Signal that no more items will be pushed.
+         * Wakes up all waiting producers and consumers.
+         */
+        void
+        close()
+        {
+            {
+                lock_guard<mutex> lock {m_mutex};
+                m_closed = true;
+            }
+
+            m_not_full.notify_all();
+            m_not_empty.notify_all();
+        }
+    };
+
+}
+
+#endif //XMREG01_BOUNDEDQUEUE_H
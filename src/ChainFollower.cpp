@@ -0,0 +1,179 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "ChainFollower.h"
+
+#include <thread>
+#include <chrono>
+
+
+namespace xmreg
+{
+
+    ChainFollower::ChainFollower(MicroCore& mcore,
+                                 uint64_t start_height,
+                                 size_t reorg_depth)
+            : m_mcore(mcore),
+              m_next_height {start_height},
+              m_reorg_depth {reorg_depth > 0 ? reorg_depth : 1}
+    {}
+
+
+    /**
+     * Process all blocks added since the last poll.
+     *
+     * New blocks are found by looking up the next height
+     * in the database, not by the blockchain height, which
+     * is cached when the database is opened.
+     *
+     * returns false if a block could not be read
+     */
+    bool
+    ChainFollower::poll(const block_processor& process_block,
+                        const rollback_handler& on_rollback)
+    {
+        try
+        {
+            if (!check_reorg(on_rollback))
+            {
+                return false;
+            }
+
+            while (!stop_requested() && m_mcore.has_block(m_next_height))
+            {
+                if (!process_next_block(process_block))
+                {
+                    return false;
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            cerr << e.what() << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Process block at m_next_height, and remember its hash
+     */
+    bool
+    ChainFollower::process_next_block(const block_processor& process_block)
+    {
+        block blk;
+
+        if (!m_mcore.get_block_by_height(m_next_height, blk))
+        {
+            return false;
+        }
+
+        list<transaction> txs;
+
+        if (!m_mcore.get_block_txs(blk, txs))
+        {
+            return false;
+        }
+
+        process_block(m_next_height, blk, txs);
+
+        m_recent_blocks.emplace_back(m_next_height, get_block_hash(blk));
+
+        if (m_recent_blocks.size() > m_reorg_depth)
+        {
+            m_recent_blocks.pop_front();
+        }
+
+        ++m_next_height;
+
+        return true;
+    }
+
+
+    /**
+     * Poll the blockchain every poll_interval_ms milliseconds
+     * until a stop signal is received.
+     */
+    void
+    ChainFollower::run(uint64_t poll_interval_ms,
+                       const block_processor& process_block,
+                       const rollback_handler& on_rollback)
+    {
+        while (!stop_requested())
+        {
+            if (!poll(process_block, on_rollback))
+            {
+                cerr << "Cant read new blocks, will try again." << endl;
+            }
+
+            this_thread::sleep_for(chrono::milliseconds(poll_interval_ms));
+        }
+    }
+
+
+    uint64_t
+    ChainFollower::next_height() const
+    {
+        return m_next_height;
+    }
+
+
+    /**
+     * Compare remembered hashes with the blockchain, starting from
+     * the newest one, and roll back to the last block still there.
+     *
+     * If the reorganization is deeper than the number of remembered
+     * blocks, we continue from the oldest remembered block.
+     *
+     * Blocks are looked up in the database each time, so blocks
+     * removed by the daemon give null hash, and do not match.
+     */
+    bool
+    ChainFollower::check_reorg(const rollback_handler& on_rollback)
+    {
+        if (m_recent_blocks.empty())
+        {
+            return true;
+        }
+
+        Blockchain& core_storage = m_mcore.get_core();
+
+        bool rolled_back {false};
+
+        while (!m_recent_blocks.empty())
+        {
+            const pair<uint64_t, crypto::hash>& recent = m_recent_blocks.back();
+
+            if (core_storage.get_block_id_by_height(recent.first) == recent.second)
+            {
+                break;
+            }
+
+            m_next_height = recent.first;
+
+            m_recent_blocks.pop_back();
+
+            rolled_back = true;
+        }
+
+        if (!rolled_back)
+        {
+            return true;
+        }
+
+        if (m_recent_blocks.empty())
+        {
+            cerr << "Blockchain reorganization deeper than "
+                 << m_reorg_depth << " blocks, continuing from block "
+                 << m_next_height << endl;
+        }
+
+        on_rollback(m_next_height > 0 ? m_next_height - 1 : 0);
+
+        return true;
+    }
+
+}
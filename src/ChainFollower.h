@@ -0,0 +1,76 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_CHAINFOLLOWER_H
+#define XMREG01_CHAINFOLLOWER_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "chain_scan.h"
+
+#include <deque>
+#include <functional>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    using rollback_handler = function<void(uint64_t common_height)>;
+
+
+    /**
+     * Follows the blockchain as a daemon appends blocks
+     * to the lmdb database, passing each new block to
+     * a block_processor exactly once.
+     *
+     * Hashes of the last reorg_depth processed blocks are
+     * remembered. If any of them changes, blocks after the last
+     * unchanged one are rolled back, i.e., the rollback_handler
+     * is told about it and those blocks are processed again
+     * in their new version.
+     */
+    class ChainFollower
+    {
+        MicroCore& m_mcore;
+
+        uint64_t m_next_height;
+
+        size_t m_reorg_depth;
+
+        // height and hash of recently processed blocks
+        deque<pair<uint64_t, crypto::hash>> m_recent_blocks;
+
+    public:
+
+        ChainFollower(MicroCore& mcore,
+                      uint64_t start_height,
+                      size_t reorg_depth = 10);
+
+        bool
+        poll(const block_processor& process_block,
+             const rollback_handler& on_rollback);
+
+        void
+        run(uint64_t poll_interval_ms,
+            const block_processor& process_block,
+            const rollback_handler& on_rollback);
+
+        uint64_t
+        next_height() const;
+
+    private:
+
+        bool
+        check_reorg(const rollback_handler& on_rollback);
+
+        bool
+        process_next_block(const block_processor& process_block);
+    };
+
+}
+
+#endif //XMREG01_CHAINFOLLOWER_H
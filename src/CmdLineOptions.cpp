@@ -23,16 +23,112 @@ namespace xmreg
         desc.add_options()
                 ("help,h", value<bool>()->default_value(false)->implicit_value(true),
                  "produce help message")
-                ("txhash,t", value<string>(),
-                 "transaction hash")
+                ("txhash,t", value<vector<string>>()->multitoken(),
+                 "transaction hash(es)")
+                ("txhash-file", value<string>(),
+                 "file with transaction hashes, one per line")
                 ("viewkey,v", value<string>(),
                  "private view key string")
                 ("address,a", value<string>(),
                  "monero address string")
+                ("spendkey,s", value<string>(),
+                 "private spend key string, used only to generate key images")
+                ("key-images", value<bool>()->default_value(false)->implicit_value(true),
+                 "find our outputs in the given height range, generate their key images "
+                 "and check which of them are spent. Requires address, viewkey and spendkey")
+                ("spend-ages", value<bool>()->default_value(false)->implicit_value(true),
+                 "find inputs spending our outputs in the given height range, and show "
+                 "age and rank in ring of each real spend, with their distributions. "
+                 "Requires address, viewkey and spendkey")
+                ("accounts-file", value<string>(),
+                 "file with monero address and private view key pairs, one pair per line")
+                ("decoy-exposure", value<bool>()->default_value(false)->implicit_value(true),
+                 "find our outputs in the given height range, and all rings "
+                 "using them as decoys. With spendkey, rings spending them "
+                 "are told apart")
+                ("scan-outputs", value<bool>()->default_value(false)->implicit_value(true),
+                 "find outputs of the given address and viewkey, or accounts "
+                 "from the accounts file, in the given height range")
+                ("analyze-blocks", value<bool>()->default_value(false)->implicit_value(true),
+                 "analyze all non-coinbase transactions in the given height range, "
+                 "instead of the given transaction hashes")
+                ("verify", value<bool>()->default_value(false)->implicit_value(true),
+                 "check ring signatures of inputs of the given transactions")
+                ("verify-blocks", value<bool>()->default_value(false)->implicit_value(true),
+                 "check ring signatures of all transactions in the given height range "
+                 "and report failures and throughput")
+                ("build-ring-cache", value<string>(),
+                 "extract rings of inputs in the given height range, with heights "
+                 "of their members, and save them into the given cache file")
+                ("ring-cache", value<string>(),
+                 "ring cache file saved with build-ring-cache. Rings are read from it, "
+                 "instead of from the blockchain, when building ring graph or decoy counts")
+                ("build-ring-graph", value<string>(),
+                 "build graph of inputs and outputs referenced by their rings "
+                 "in the given height range, and save it into the given file")
+                ("ring-graph", value<string>(),
+                 "ring graph file saved with build-ring-graph. Used to mark ring "
+                 "members provably spent elsewhere, starting from zero-mixin inputs")
+                ("build-decoy-counts", value<string>(),
+                 "count how many rings in the given height range reference "
+                 "each output, and save the counts into the given file")
+                ("decoy-counts", value<string>(),
+                 "decoy counts file saved with build-decoy-counts. Used to show "
+                 "how many times each ring member was used in rings")
+                ("build-keyimage-index", value<string>(),
+                 "index key images spent in the given height range, "
+                 "save the index in the given file, and exit")
+                ("keyimage-index", value<string>(),
+                 "key image index file saved with build-keyimage-index")
+                ("keyimage", value<vector<string>>()->multitoken(),
+                 "key image(s) to show the spending input of, "
+                 "found using keyimage-index")
+                ("build-payment-id-index", value<string>(),
+                 "index payment ids of txs in the given height range, "
+                 "save the index in the given file, and exit")
+                ("payment-id-index", value<string>(),
+                 "payment id index file saved with build-payment-id-index")
+                ("payment-id", value<vector<string>>()->multitoken(),
+                 "payment id(s), normal or encrypted, to show txs of, "
+                 "found using payment-id-index")
+                ("checkpoint", value<string>(),
+                 "file to save progress of a scan in, and to resume it from")
+                ("from-height", value<size_t>(),
+                 "first block height to scan")
+                ("to-height", value<size_t>(),
+                 "last block height to scan")
+                ("from-date", value<string>(),
+                 "first day to scan, e.g., 2016-04-17; overrides from-height")
+                ("to-date", value<string>(),
+                 "last day to scan, e.g., 2016-04-30; limits to-height")
+                ("follow", value<bool>()->default_value(false)->implicit_value(true),
+                 "keep running and show rings and our outputs in new blocks as they are added")
+                ("poll-interval", value<size_t>()->default_value(500),
+                 "how often to check for new blocks when following, in milliseconds")
+                ("reorg-depth", value<size_t>()->default_value(10),
+                 "number of recent blocks that can be rolled back when following")
+                ("threads", value<size_t>()->default_value(0),
+                 "number of worker threads, 0 for one per core")
                 ("bc-path,b", value<string>(),
                  "path to lmdb blockchain")
                 ("testnet",  value<bool>()->default_value(false)->implicit_value(true),
-                 "is the address from testnet network");
+                 "is the address from testnet network")
+                ("bench-scanner", value<size_t>(),
+                 "benchmark deriving the given number of output keys with "
+                 "crypto::derive_public_key and with OutputScanner, and exit")
+                ("bench-hex", value<size_t>(),
+                 "benchmark hex encoding of the given number of keys with "
+                 "epee::string_tools::pod_to_hex and with hex_encode, and exit")
+                ("prefetch", value<size_t>()->default_value(8),
+                 "number of transactions to analyze in advance of printing them")
+                ("no-color", value<bool>()->default_value(false)->implicit_value(true),
+                 "print analyzed transactions without terminal color codes")
+                ("ring-columns", value<string>(),
+                 "keep ring members of analyzed transactions column by column, "
+                 "and save them into the given binary file, instead of printing them")
+                ("ndjson", value<string>(),
+                 "write ring members of analyzed transactions into the given file, "
+                 "one json object per line, instead of printing them");
 
 
         store(command_line_parser(acc, avv)
@@ -77,4 +173,7 @@ namespace xmreg
     template  boost::optional<size_t>
             CmdLineOptions::get_option<size_t>(const string & opt_name) const;
 
+    template  boost::optional<vector<string>>
+            CmdLineOptions::get_option<vector<string>>(const string & opt_name) const;
+
 }
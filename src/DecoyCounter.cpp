@@ -0,0 +1,256 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "DecoyCounter.h"
+
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        const char DECOY_COUNTS_MAGIC[8] {'X', 'M', 'R', 'D', 'E', 'C', 'O', 'Y'};
+
+        const uint64_t DECOY_COUNTS_VERSION {1};
+
+        struct decoy_counts_header
+        {
+            char     magic[8];
+            uint64_t version;
+            uint64_t from_height;
+            uint64_t to_height;
+            uint64_t amount_no;
+            uint64_t output_no;
+        };
+
+        // counters of all outputs of a single amount
+        struct amount_counters
+        {
+            unique_ptr<atomic<uint32_t>[]> counts;
+            uint64_t output_no {0};
+        };
+    }
+
+
+    /**
+     * Count ring members of all inputs given by the source.
+     *
+     * Rings are read in parallel. Counters of an amount are
+     * allocated when the amount is first seen, sized by the
+     * number of its outputs, and then incremented atomically
+     * by all threads. Each chunk caches pointers to the counters it uses,
+     * so the lock is taken only once per chunk and amount.
+     */
+    bool
+    DecoyCounter::build(const RingSource& source, size_t thread_no)
+    {
+        map<uint64_t, amount_counters> counters;
+        mutex counters_mutex;
+
+        vector<unordered_map<uint64_t, amount_counters*>> chunk_counters(
+                source.chunk_no());
+
+        bool completed = source.scan([&](size_t chunk_idx, const input_ring& ring)
+        {
+            amount_counters*& amount_cnt = chunk_counters[chunk_idx][ring.amount];
+
+            if (!amount_cnt)
+            {
+                lock_guard<mutex> lock {counters_mutex};
+
+                amount_counters& new_cnt = counters[ring.amount];
+
+                if (!new_cnt.counts)
+                {
+                    new_cnt.output_no = source.output_no(ring.amount);
+                    new_cnt.counts.reset(new atomic<uint32_t>[new_cnt.output_no]());
+                }
+
+                amount_cnt = &new_cnt;
+            }
+
+            for (uint64_t global_index: ring.absolute_offsets)
+            {
+                if (global_index < amount_cnt->output_no)
+                {
+                    amount_cnt->counts[global_index].fetch_add(1, memory_order_relaxed);
+                }
+            }
+        }, thread_no);
+
+        if (!completed)
+        {
+            return false;
+        }
+
+        m_amounts_vec.clear();
+        m_amount_offsets_vec.assign(1, 0);
+        m_counts_vec.clear();
+
+        for (const auto& amount_cnt: counters)
+        {
+            m_amounts_vec.push_back(amount_cnt.first);
+
+            for (uint64_t i = 0; i < amount_cnt.second.output_no; ++i)
+            {
+                m_counts_vec.push_back(amount_cnt.second.counts[i].load());
+            }
+
+            m_amount_offsets_vec.push_back(m_counts_vec.size());
+        }
+
+        m_from_height = source.from_height();
+        m_to_height   = source.to_height();
+
+        m_file.close();
+
+        m_amounts        = {m_amounts_vec.data(), m_amounts_vec.size()};
+        m_amount_offsets = {m_amount_offsets_vec.data(), m_amount_offsets_vec.size()};
+        m_counts         = {m_counts_vec.data(), m_counts_vec.size()};
+
+        return true;
+    }
+
+
+    bool
+    DecoyCounter::save(const string& file_path) const
+    {
+        ofstream out {file_path, ios::binary | ios::trunc};
+
+        if (!out)
+        {
+            cerr << "Cant write decoy counts: " << file_path << endl;
+            return false;
+        }
+
+        decoy_counts_header header;
+
+        memcpy(header.magic, DECOY_COUNTS_MAGIC, sizeof(header.magic));
+
+        header.version     = DECOY_COUNTS_VERSION;
+        header.from_height = m_from_height;
+        header.to_height   = m_to_height;
+        header.amount_no   = m_amounts.size();
+        header.output_no   = m_counts.size();
+
+        write_padded_array(out, &header, 1);
+        write_padded_array(out, m_amounts.begin(), m_amounts.size());
+        write_padded_array(out, m_amount_offsets.begin(), m_amount_offsets.size());
+        write_padded_array(out, m_counts.begin(), m_counts.size());
+
+        if (!out.flush())
+        {
+            cerr << "Cant write decoy counts: " << file_path << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    bool
+    DecoyCounter::load(const string& file_path)
+    {
+        if (!m_file.open(file_path))
+        {
+            return false;
+        }
+
+        decoy_counts_header header;
+
+        if (m_file.size() < sizeof(header))
+        {
+            cerr << "Decoy counts file too short: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        memcpy(&header, m_file.data(), sizeof(header));
+
+        if (memcmp(header.magic, DECOY_COUNTS_MAGIC, sizeof(header.magic)) != 0
+            || header.version != DECOY_COUNTS_VERSION)
+        {
+            cerr << "Not a decoy counts file: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        size_t offset = padded_size(sizeof(header));
+
+        if (!map_padded_array(m_file, offset, header.amount_no, m_amounts)
+            || !map_padded_array(m_file, offset, header.amount_no + 1, m_amount_offsets)
+            || !map_padded_array(m_file, offset, header.output_no, m_counts))
+        {
+            cerr << "Decoy counts file is truncated: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        m_from_height = header.from_height;
+        m_to_height   = header.to_height;
+
+        m_amounts_vec        = vector<uint64_t> {};
+        m_amount_offsets_vec = vector<uint64_t> {};
+        m_counts_vec         = vector<uint32_t> {};
+
+        return true;
+    }
+
+
+    uint64_t
+    DecoyCounter::from_height() const
+    {
+        return m_from_height;
+    }
+
+    uint64_t
+    DecoyCounter::to_height() const
+    {
+        return m_to_height;
+    }
+
+    size_t
+    DecoyCounter::amount_no() const
+    {
+        return m_amounts.size();
+    }
+
+
+    /**
+     * returns number of rings referencing the given output,
+     * or 0 if it is not known
+     */
+    uint32_t
+    DecoyCounter::times_used(uint64_t amount, uint64_t global_index) const
+    {
+        const uint64_t* it = lower_bound(m_amounts.begin(), m_amounts.end(), amount);
+
+        if (it == m_amounts.end() || *it != amount)
+        {
+            return 0;
+        }
+
+        size_t amount_idx = it - m_amounts.begin();
+
+        uint64_t first = m_amount_offsets[amount_idx];
+        uint64_t next  = m_amount_offsets[amount_idx + 1];
+
+        if (global_index >= next - first)
+        {
+            return 0;
+        }
+
+        return m_counts[first + global_index];
+    }
+
+}
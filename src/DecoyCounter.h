@@ -0,0 +1,79 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_DECOYCOUNTER_H
+#define XMREG01_DECOYCOUNTER_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "MappedFile.h"
+#include "RingSource.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Number of rings referencing each output, i.e., how many
+     * times it was used as a ring member, in a given height range.
+     *
+     * Counts are kept in a dense 32-bit array per amount, indexed
+     * by global index of the output, with arrays of all amounts
+     * one after another:
+     *
+     *   counts[amount_offsets[a] + global_index]
+     *
+     * Like RingGraph, the counts can be saved into a file
+     * and later memory mapped.
+     */
+    class DecoyCounter
+    {
+        uint64_t m_from_height {0};
+        uint64_t m_to_height {0};
+
+        // storage for the arrays, when built in memory
+        vector<uint64_t> m_amounts_vec;
+        vector<uint64_t> m_amount_offsets_vec;
+        vector<uint32_t> m_counts_vec;
+
+        // storage for the arrays, when loaded from a file
+        MappedFile m_file;
+
+        array_view<uint64_t> m_amounts;
+        array_view<uint64_t> m_amount_offsets;
+        array_view<uint32_t> m_counts;
+
+    public:
+
+        bool
+        build(const RingSource& source, size_t thread_no = 0);
+
+        bool
+        save(const string& file_path) const;
+
+        bool
+        load(const string& file_path);
+
+        uint64_t
+        from_height() const;
+
+        uint64_t
+        to_height() const;
+
+        size_t
+        amount_no() const;
+
+        uint32_t
+        times_used(uint64_t amount, uint64_t global_index) const;
+    };
+
+}
+
+#endif //XMREG01_DECOYCOUNTER_H
@@ -0,0 +1,286 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "KeyImageIndex.h"
+#include "chain_scan.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        const char KEY_IMAGE_INDEX_MAGIC[8] {'X', 'M', 'R', 'K', 'I', 'M', 'G', 'I'};
+
+        const uint64_t KEY_IMAGE_INDEX_VERSION {1};
+
+        // number of blocks each thread reads at a time
+        const uint64_t INDEX_CHUNK_SIZE {10000};
+
+        struct key_image_index_header
+        {
+            char     magic[8];
+            uint64_t version;
+            uint64_t from_height;
+            uint64_t to_height;
+            uint64_t key_image_no;
+        };
+
+        struct index_entry
+        {
+            key_image       k_image;
+            key_image_spend spend;
+        };
+
+        inline int
+        compare_key_images(const key_image& a, const key_image& b)
+        {
+            return memcmp(&a, &b, sizeof(key_image));
+        }
+
+
+        /**
+         * Put sorted entries into Eytzinger order, i.e., node k
+         * of the tree (counting from 1) has children 2k and 2k + 1,
+         * and in-order traversal of the tree gives the sorted order.
+         *
+         * returns index of the next sorted entry to place
+         */
+        size_t
+        fill_eytzinger(const vector<index_entry>& sorted,
+                       size_t sorted_i, size_t k,
+                       vector<key_image>& key_images,
+                       vector<key_image_spend>& spends)
+        {
+            if (k > sorted.size())
+            {
+                return sorted_i;
+            }
+
+            sorted_i = fill_eytzinger(sorted, sorted_i, 2 * k, key_images, spends);
+
+            key_images[k - 1] = sorted[sorted_i].k_image;
+            spends[k - 1]     = sorted[sorted_i].spend;
+
+            return fill_eytzinger(sorted, sorted_i + 1, 2 * k + 1, key_images, spends);
+        }
+    }
+
+
+    /**
+     * Find spends of all key images in the given height range
+     * and index them. Blocks are read in parallel, in chunks.
+     *
+     * returns false if the scan was stopped by a signal
+     */
+    bool
+    KeyImageIndex::build(MicroCore& mcore,
+                         uint64_t from_height,
+                         uint64_t to_height,
+                         size_t thread_no)
+    {
+        vector<vector<index_entry>> chunks(
+                get_chunk_no(from_height, to_height, INDEX_CHUNK_SIZE));
+
+        bool completed = parallel_scan_rings(
+                mcore, from_height, to_height, INDEX_CHUNK_SIZE,
+                [&](size_t chunk_idx, const input_ring& ring)
+        {
+            chunks[chunk_idx].push_back(index_entry {
+                    ring.k_image,
+                    key_image_spend {ring.tx_hash, ring.blk_height, ring.in_i}});
+        }, thread_no);
+
+        if (!completed)
+        {
+            return false;
+        }
+
+        vector<index_entry> sorted;
+
+        size_t entry_no {0};
+
+        for (const vector<index_entry>& chunk: chunks)
+        {
+            entry_no += chunk.size();
+        }
+
+        sorted.reserve(entry_no);
+
+        for (vector<index_entry>& chunk: chunks)
+        {
+            sorted.insert(sorted.end(), chunk.begin(), chunk.end());
+
+            // free memory of merged chunk as we go
+            chunk = vector<index_entry> {};
+        }
+
+        sort(sorted.begin(), sorted.end(),
+             [](const index_entry& a, const index_entry& b)
+             {
+                 return compare_key_images(a.k_image, b.k_image) < 0;
+             });
+
+        m_key_images_vec.resize(sorted.size());
+        m_spends_vec.resize(sorted.size());
+
+        fill_eytzinger(sorted, 0, 1, m_key_images_vec, m_spends_vec);
+
+        m_from_height = from_height;
+        m_to_height   = to_height;
+
+        m_file.close();
+
+        m_key_images = {m_key_images_vec.data(), m_key_images_vec.size()};
+        m_spends     = {m_spends_vec.data(), m_spends_vec.size()};
+
+        return true;
+    }
+
+
+    /**
+     * Save the index into a binary file, which can
+     * be later memory mapped using load().
+     */
+    bool
+    KeyImageIndex::save(const string& file_path) const
+    {
+        ofstream out {file_path, ios::binary | ios::trunc};
+
+        if (!out)
+        {
+            cerr << "Cant write key image index: " << file_path << endl;
+            return false;
+        }
+
+        key_image_index_header header;
+
+        memcpy(header.magic, KEY_IMAGE_INDEX_MAGIC, sizeof(header.magic));
+
+        header.version      = KEY_IMAGE_INDEX_VERSION;
+        header.from_height  = m_from_height;
+        header.to_height    = m_to_height;
+        header.key_image_no = m_key_images.size();
+
+        write_padded_array(out, &header, 1);
+        write_padded_array(out, m_key_images.begin(), m_key_images.size());
+        write_padded_array(out, m_spends.begin(), m_spends.size());
+
+        if (!out.flush())
+        {
+            cerr << "Cant write key image index: " << file_path << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Memory map the index saved with save()
+     */
+    bool
+    KeyImageIndex::load(const string& file_path)
+    {
+        if (!m_file.open(file_path))
+        {
+            return false;
+        }
+
+        if (m_file.size() < sizeof(key_image_index_header))
+        {
+            cerr << "Key image index file too short: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        key_image_index_header header;
+        memcpy(&header, m_file.data(), sizeof(header));
+
+        if (memcmp(header.magic, KEY_IMAGE_INDEX_MAGIC, sizeof(header.magic)) != 0
+            || header.version != KEY_IMAGE_INDEX_VERSION)
+        {
+            cerr << "Not a key image index file: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        size_t offset = padded_size(sizeof(key_image_index_header));
+
+        if (!map_padded_array(m_file, offset, header.key_image_no, m_key_images)
+            || !map_padded_array(m_file, offset, header.key_image_no, m_spends))
+        {
+            cerr << "Key image index file is truncated: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        m_from_height = header.from_height;
+        m_to_height   = header.to_height;
+
+        // free memory of previously built index
+        m_key_images_vec = vector<key_image> {};
+        m_spends_vec     = vector<key_image_spend> {};
+
+        return true;
+    }
+
+
+    uint64_t
+    KeyImageIndex::from_height() const
+    {
+        return m_from_height;
+    }
+
+    uint64_t
+    KeyImageIndex::to_height() const
+    {
+        return m_to_height;
+    }
+
+    size_t
+    KeyImageIndex::key_image_no() const
+    {
+        return m_key_images.size();
+    }
+
+
+    /**
+     * Find where the given key image was spent.
+     *
+     * Goes down the tree without branching on the comparison,
+     * to the leaf past the lower bound. The lower bound is then
+     * the node where the path last went left, found by dropping
+     * the trailing right turns, i.e., 1 bits, and one more bit.
+     *
+     * returns false if the key image is not in the index
+     */
+    bool
+    KeyImageIndex::find(const key_image& k_image, key_image_spend& spend) const
+    {
+        size_t n = m_key_images.size();
+        size_t k = 1;
+
+        while (k <= n)
+        {
+            k = 2 * k + (compare_key_images(m_key_images[k - 1], k_image) < 0);
+        }
+
+        k >>= __builtin_ffsll(static_cast<long long>(~k));
+
+        if (k == 0 || compare_key_images(m_key_images[k - 1], k_image) != 0)
+        {
+            return false;
+        }
+
+        spend = m_spends[k - 1];
+
+        return true;
+    }
+
+}
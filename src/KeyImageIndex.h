@@ -0,0 +1,94 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_KEYIMAGEINDEX_H
+#define XMREG01_KEYIMAGEINDEX_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Where a key image was spent, i.e., its
+     * tx, input index and block height
+     */
+    struct key_image_spend
+    {
+        crypto::hash tx_hash;
+        uint64_t     blk_height;
+        uint64_t     in_i;
+    };
+
+
+    /**
+     * Index of key images spent in a given height range,
+     * so that the tx spending a key image can be found
+     * without scanning the blockchain.
+     *
+     * Key images are kept sorted in Eytzinger layout, i.e.,
+     * as a complete binary search tree stored level by level,
+     * with the spend of each key image in a parallel array.
+     * A search touches nodes near each other first, so the top
+     * levels stay in the cache, and there are no pointers,
+     * so the index can be saved and memory mapped as it is.
+     *
+     * Rings do not matter here, so the index is built from
+     * the blockchain, not from a RingSource, which
+     * may not keep tx hashes.
+     */
+    class KeyImageIndex
+    {
+        uint64_t m_from_height {0};
+        uint64_t m_to_height {0};
+
+        // storage for the arrays, when built in memory
+        vector<key_image>       m_key_images_vec;
+        vector<key_image_spend> m_spends_vec;
+
+        // storage for the arrays, when loaded from a file
+        MappedFile m_file;
+
+        array_view<key_image>       m_key_images;
+        array_view<key_image_spend> m_spends;
+
+    public:
+
+        bool
+        build(MicroCore& mcore,
+              uint64_t from_height,
+              uint64_t to_height,
+              size_t thread_no = 0);
+
+        bool
+        save(const string& file_path) const;
+
+        bool
+        load(const string& file_path);
+
+        uint64_t
+        from_height() const;
+
+        uint64_t
+        to_height() const;
+
+        size_t
+        key_image_no() const;
+
+        bool
+        find(const key_image& k_image, key_image_spend& spend) const;
+    };
+
+}
+
+#endif //XMREG01_KEYIMAGEINDEX_H
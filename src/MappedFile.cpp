@@ -0,0 +1,101 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "MappedFile.h"
+
+#include <iostream>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace xmreg
+{
+
+    /**
+     * Map the given file into memory.
+     *
+     * returns false if the file cant be opened or mapped
+     */
+    bool
+    MappedFile::open(const string& file_path)
+    {
+        close();
+
+        int fd = ::open(file_path.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            cerr << "Cant open file: " << file_path << endl;
+            return false;
+        }
+
+        struct stat file_stat;
+
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+        {
+            cerr << "Cant map empty or unreadable file: " << file_path << endl;
+            ::close(fd);
+            return false;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size),
+                          PROT_READ, MAP_SHARED, fd, 0);
+
+        // mapping stays valid after the descriptor is closed
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+        {
+            cerr << "Cant map file: " << file_path << endl;
+            return false;
+        }
+
+        m_data = data;
+        m_size = static_cast<size_t>(file_stat.st_size);
+
+        return true;
+    }
+
+
+    void
+    MappedFile::close()
+    {
+        if (m_data)
+        {
+            munmap(m_data, m_size);
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+
+    bool
+    MappedFile::is_open() const
+    {
+        return m_data != nullptr;
+    }
+
+    const char*
+    MappedFile::data() const
+    {
+        return static_cast<const char*>(m_data);
+    }
+
+    size_t
+    MappedFile::size() const
+    {
+        return m_size;
+    }
+
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+}
@@ -0,0 +1,148 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_MAPPEDFILE_H
+#define XMREG01_MAPPEDFILE_H
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+namespace xmreg
+{
+    using namespace std;
+
+
+    /**
+     * Read-only memory mapping of a whole file.
+     *
+     * Used for indices and caches saved by this program,
+     * so that they can be used right away, without reading
+     * and parsing them first. Pages are loaded by the OS
+     * as they are accessed.
+     */
+    class MappedFile
+    {
+        void*  m_data {nullptr};
+        size_t m_size {0};
+
+    public:
+
+        MappedFile() = default;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool
+        open(const string& file_path);
+
+        void
+        close();
+
+        bool
+        is_open() const;
+
+        const char*
+        data() const;
+
+        size_t
+        size() const;
+
+        ~MappedFile();
+    };
+
+
+    /**
+     * Non-owning view of a contiguous array, either in
+     * a std::vector or in a memory mapped file.
+     */
+    template <typename T>
+    struct array_view
+    {
+        const T* m_data {nullptr};
+        size_t   m_size {0};
+
+        array_view() = default;
+
+        array_view(const T* data, size_t size)
+                : m_data {data}, m_size {size}
+        {}
+
+        const T&
+        operator[](size_t i) const { return m_data[i]; }
+
+        const T*
+        begin() const { return m_data; }
+
+        const T*
+        end() const { return m_data + m_size; }
+
+        size_t
+        size() const { return m_size; }
+
+        bool
+        empty() const { return m_size == 0; }
+    };
+
+
+    /**
+     * Arrays in binary files of this program are 8 byte aligned,
+     * so that they can be used directly from a mapped file.
+     */
+    inline size_t
+    padded_size(size_t size)
+    {
+        return (size + 7) & ~size_t {7};
+    }
+
+
+    /**
+     * Write array followed by padding to 8 bytes
+     */
+    template <typename T>
+    void
+    write_padded_array(ostream& out, const T* data, size_t item_no)
+    {
+        static const char padding[8] {};
+
+        size_t size = item_no * sizeof(T);
+
+        out.write(reinterpret_cast<const char*>(data), size);
+        out.write(padding, padded_size(size) - size);
+    }
+
+
+    /**
+     * Point view to array written with write_padded_array
+     * at the given offset of the mapped file, and move
+     * the offset past it.
+     *
+     * item_no usually comes from the file header, so it is
+     * checked before being multiplied, which could overflow.
+     *
+     * returns false if the file is too short
+     */
+    template <typename T>
+    bool
+    map_padded_array(const MappedFile& file, size_t& offset,
+                     size_t item_no, array_view<T>& view)
+    {
+        if (offset > file.size() || item_no > (file.size() - offset) / sizeof(T))
+        {
+            return false;
+        }
+
+        size_t size = item_no * sizeof(T);
+
+        view = array_view<T> {
+                reinterpret_cast<const T*>(file.data() + offset), item_no};
+
+        offset += padded_size(size);
+
+        return true;
+    }
+
+}
+
+#endif //XMREG01_MAPPEDFILE_H
@@ -3,6 +3,9 @@
 //
 
 #include "MicroCore.h"
+#include "parallel.h"
+
+#include <atomic>
 
 namespace xmreg
 {
@@ -134,6 +137,42 @@ namespace xmreg
 
 
 
+    /**
+     * Get all transactions in a given block,
+     * starting with its coinbase transaction.
+     */
+    bool
+    MicroCore::get_block_txs(const block& blk, list<transaction>& txs)
+    {
+        // initialize the first list with transaction for solving
+        // the block i.e. coinbase.
+        txs = {blk.miner_tx};
+
+        list<crypto::hash> missed_txs;
+
+        if (!m_blockchain_storage.get_transactions(blk.tx_hashes, txs, missed_txs))
+        {
+            return false;
+        }
+
+        if (!missed_txs.empty())
+        {
+            cerr << "Transactions not found in blk: "
+                 << get_block_hash(blk) << endl;
+
+            for (const crypto::hash& h : missed_txs)
+            {
+                cerr << " - tx hash: " << h << endl;
+            }
+
+            return false;
+        }
+
+        return true;
+    }
+
+
+
     /**
      * Find output with given public key in a given transaction
      */
@@ -198,29 +237,14 @@ namespace xmreg
 
 
         // get all transactions in the block found
-        // initialize the first list with transaction for solving
-        // the block i.e. coinbase.
-        list<transaction> txs {blk.miner_tx};
-        list<crypto::hash> missed_txs;
+        list<transaction> txs;
 
-        if (!m_blockchain_storage.get_transactions(blk.tx_hashes, txs, missed_txs))
+        if (!get_block_txs(blk, txs))
         {
             cerr << "Cant find transcations in block: " << block_height << endl;
             return false;
         }
 
-        if (!missed_txs.empty())
-        {
-            cerr << "Transactions not found in blk: " << block_height << endl;
-
-            for (const crypto::hash& h : missed_txs)
-            {
-                cerr << " - tx hash: " << h << endl;
-            }
-
-            return false;
-        }
-
 
         // search outputs in each transactions
         // until output with pubkey of interest is found
@@ -250,15 +274,152 @@ namespace xmreg
     uint64_t
     MicroCore::get_blk_timestamp(uint64_t blk_height)
     {
-        cryptonote::block blk;
+        uint64_t timestamp {0};
 
-        if (!get_block_by_height(blk_height, blk))
+        if (!get_blk_timestamp(blk_height, timestamp))
         {
             cerr << "Cant get block by height: " << blk_height << endl;
-            return 0;
         }
 
-        return blk.timestamp;
+        return timestamp;
+    }
+
+
+    /**
+     * Read only the timestamp of the block, without
+     * getting and parsing the whole block
+     *
+     * returns false if there is no such block
+     */
+    bool
+    MicroCore::get_blk_timestamp(uint64_t blk_height, uint64_t& timestamp)
+    {
+        try
+        {
+            timestamp = m_blockchain_storage.get_db().get_block_timestamp(blk_height);
+        }
+        catch (const exception&)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Check if block of the given height is in the database.
+     *
+     * get_current_blockchain_height gives the height cached
+     * by BlockchainLMDB when the database was opened, and it
+     * does not change when a running daemon appends blocks.
+     * The block hash lookup here uses a new read transaction,
+     * so it sees what the daemon has committed so far.
+     *
+     * Other database errors are thrown.
+     */
+    bool
+    MicroCore::has_block(uint64_t blk_height)
+    {
+        try
+        {
+            m_blockchain_storage.get_db().get_block_hash_from_height(blk_height);
+        }
+        catch (const BLOCK_DNE&)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Read timestamps of all blocks into memory.
+     *
+     * If they were already loaded, only the blocks
+     * added since then are read.
+     */
+    bool
+    MicroCore::load_timestamps()
+    {
+        BlockchainDB& db = m_blockchain_storage.get_db();
+
+        uint64_t chain_height = m_blockchain_storage.get_current_blockchain_height();
+        uint64_t loaded_no    = m_blk_timestamps.size();
+
+        if (chain_height <= loaded_no)
+        {
+            return true;
+        }
+
+        m_blk_timestamps.resize(chain_height);
+
+        atomic<bool> all_read {true};
+
+        // timestamps are independent reads, so
+        // they are spread over all cores
+        parallel_for(chain_height - loaded_no, [&](size_t i)
+        {
+            try
+            {
+                m_blk_timestamps[loaded_no + i] = db.get_block_timestamp(loaded_no + i);
+            }
+            catch (const exception&)
+            {
+                all_read = false;
+            }
+        });
+
+        if (!all_read)
+        {
+            cerr << "Cant read all block timestamps" << endl;
+            m_blk_timestamps.resize(loaded_no);
+            return false;
+        }
+
+        m_max_timestamps.resize(chain_height);
+
+        for (uint64_t h = loaded_no; h < chain_height; ++h)
+        {
+            m_max_timestamps[h] = h > 0
+                                  ? max(m_max_timestamps[h - 1], m_blk_timestamps[h])
+                                  : m_blk_timestamps[h];
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Find the first block with timestamp not older
+     * than the given one.
+     *
+     * Block timestamps only need to be greater than the median
+     * of the previous 60 blocks, so they are not sorted.
+     * Thus the search is done on their running maximum, which is.
+     * As a result, all blocks before the returned height
+     * have timestamps older than the given one.
+     *
+     * blk_height is set to blockchain height if there is no such block
+     *
+     * returns false if block timestamps could not be read
+     */
+    bool
+    MicroCore::height_for_time(uint64_t timestamp, uint64_t& blk_height)
+    {
+        if (!load_timestamps())
+        {
+            return false;
+        }
+
+        auto it = lower_bound(m_max_timestamps.begin(),
+                              m_max_timestamps.end(),
+                              timestamp);
+
+        blk_height = static_cast<uint64_t>(it - m_max_timestamps.begin());
+
+        return true;
     }
 
 
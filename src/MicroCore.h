@@ -31,6 +31,11 @@ namespace xmreg
         tx_memory_pool m_mempool;
         Blockchain m_blockchain_storage;
 
+        // block timestamps, and their running maximum which,
+        // unlike the timestamps themselves, never decreases
+        vector<uint64_t> m_blk_timestamps;
+        vector<uint64_t> m_max_timestamps;
+
     public:
         MicroCore();
 
@@ -46,6 +51,9 @@ namespace xmreg
         bool
         get_tx(const crypto::hash& tx_hash, transaction& tx);
 
+        bool
+        get_block_txs(const block& blk, list<transaction>& txs);
+
         bool
         find_output_in_tx(const transaction& tx,
                           const public_key& output_pubkey,
@@ -61,6 +69,18 @@ namespace xmreg
         uint64_t
         get_blk_timestamp(uint64_t blk_height);
 
+        bool
+        get_blk_timestamp(uint64_t blk_height, uint64_t& timestamp);
+
+        bool
+        has_block(uint64_t blk_height);
+
+        bool
+        load_timestamps();
+
+        bool
+        height_for_time(uint64_t timestamp, uint64_t& blk_height);
+
 
         virtual ~MicroCore();
     };
@@ -0,0 +1,191 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "OutputScanner.h"
+
+#include "crypto/hash.h"
+#include "common/varint.h"
+
+#include <chrono>
+
+
+namespace xmreg
+{
+
+    /**
+     * Decompress the public spend key and keep it
+     * in the cached form used by ge_add.
+     */
+    OutputScanner::OutputScanner(const secret_key& private_view_key,
+                                 const public_key& public_spend_key)
+            : m_private_view_key {private_view_key},
+              m_public_spend_key {public_spend_key}
+    {
+        ge_p3 spend_key_point;
+
+        if (ge_frombytes_vartime(&spend_key_point,
+                                 reinterpret_cast<const unsigned char*>(&public_spend_key)) != 0)
+        {
+            cerr << "Incorrect public spend key: " << public_spend_key << endl;
+            return;
+        }
+
+        ge_p3_to_cached(&m_spend_key_cached, &spend_key_point);
+
+        m_valid = true;
+    }
+
+
+    bool
+    OutputScanner::valid() const
+    {
+        return m_valid;
+    }
+
+    const public_key&
+    OutputScanner::public_spend_key() const
+    {
+        return m_public_spend_key;
+    }
+
+
+    /**
+     * Combine tx public key with our private view key.
+     * This has to be done once per tx.
+     */
+    bool
+    OutputScanner::generate_derivation(const public_key& pub_tx_key,
+                                       key_derivation& derivation) const
+    {
+        return generate_key_derivation(pub_tx_key, m_private_view_key, derivation);
+    }
+
+
+    /**
+     * Same as crypto::derive_public_key, but using
+     * the precomputed public spend key.
+     *
+     * derived_key = Hs(derivation || output_index)*G + public_spend_key
+     */
+    bool
+    OutputScanner::derive_public_key(const key_derivation& derivation,
+                                     size_t output_index,
+                                     public_key& derived_key) const
+    {
+        if (!m_valid)
+        {
+            return false;
+        }
+
+        // derivation to scalar, i.e., hash of derivation and
+        // varint of output index, reduced mod l
+        char buf[sizeof(key_derivation) + (sizeof(size_t) * 8 + 6) / 7];
+        char* end = buf + sizeof(key_derivation);
+
+        memcpy(buf, &derivation, sizeof(key_derivation));
+        tools::write_varint(end, output_index);
+
+        crypto::hash scalar;
+        cn_fast_hash(buf, end - buf, scalar);
+
+        unsigned char* scalar_bytes = reinterpret_cast<unsigned char*>(&scalar);
+
+        sc_reduce32(scalar_bytes);
+
+        ge_p3   scalar_point;
+        ge_p1p1 sum_point;
+        ge_p2   derived_point;
+
+        ge_scalarmult_base(&scalar_point, scalar_bytes);
+        ge_add(&sum_point, &scalar_point, &m_spend_key_cached);
+        ge_p1p1_to_p2(&derived_point, &sum_point);
+        ge_tobytes(reinterpret_cast<unsigned char*>(&derived_key), &derived_point);
+
+        return true;
+    }
+
+
+    bool
+    OutputScanner::is_output_ours(const key_derivation& derivation,
+                                  size_t output_index,
+                                  const public_key& output_pubkey) const
+    {
+        public_key pubkey;
+
+        if (!derive_public_key(derivation, output_index, pubkey))
+        {
+            return false;
+        }
+
+        return pubkey == output_pubkey;
+    }
+
+
+
+    /**
+     * Derive output_no output keys using crypto::derive_public_key
+     * and OutputScanner::derive_public_key, and compare time taken.
+     *
+     * Random keys are used, so no blockchain is needed.
+     *
+     * returns time in seconds of the per-call path and of the scanner
+     */
+    array<double, 2>
+    benchmark_output_scanner(size_t output_no)
+    {
+        using clock = chrono::steady_clock;
+
+        public_key view_pub, spend_pub, tx_pub;
+        secret_key view_sec, spend_sec, tx_sec;
+
+        generate_keys(view_pub, view_sec);
+        generate_keys(spend_pub, spend_sec);
+        generate_keys(tx_pub, tx_sec);
+
+        OutputScanner scanner {view_sec, spend_pub};
+
+        key_derivation derivation;
+        scanner.generate_derivation(tx_pub, derivation);
+
+        public_key key_a, key_b;
+        size_t mismatch_no {0};
+
+        auto t0 = clock::now();
+
+        for (size_t i = 0; i < output_no; ++i)
+        {
+            crypto::derive_public_key(derivation, i, spend_pub, key_a);
+        }
+
+        auto t1 = clock::now();
+
+        for (size_t i = 0; i < output_no; ++i)
+        {
+            scanner.derive_public_key(derivation, i, key_b);
+        }
+
+        auto t2 = clock::now();
+
+        // both ways must give same keys
+        for (size_t i = 0; i < min<size_t>(output_no, 1000); ++i)
+        {
+            crypto::derive_public_key(derivation, i, spend_pub, key_a);
+            scanner.derive_public_key(derivation, i, key_b);
+
+            mismatch_no += !(key_a == key_b);
+        }
+
+        if (mismatch_no > 0)
+        {
+            cerr << "OutputScanner keys differ from "
+                 << "crypto::derive_public_key in "
+                 << mismatch_no << " cases!" << endl;
+        }
+
+        return array<double, 2> {
+                chrono::duration<double>(t1 - t0).count(),
+                chrono::duration<double>(t2 - t1).count()};
+    }
+
+}
@@ -0,0 +1,76 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_OUTPUTSCANNER_H
+#define XMREG01_OUTPUTSCANNER_H
+
+#include "monero_headers.h"
+
+extern "C" {
+#include "crypto/crypto-ops.h"
+}
+
+#include <array>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Checks if outputs belong to a given private view key
+     * and public spend key.
+     *
+     * crypto::derive_public_key decompresses the public spend
+     * key from its bytes each time it is called. Here, this is
+     * done only once in the constructor, and the spend key
+     * is kept in the form ready for point addition. Thus deriving
+     * an output key costs one base point multiplication and
+     * one addition.
+     */
+    class OutputScanner
+    {
+        secret_key m_private_view_key;
+        public_key m_public_spend_key;
+
+        // public spend key precomputed for ge_add
+        ge_cached  m_spend_key_cached;
+
+        bool       m_valid {false};
+
+    public:
+
+        OutputScanner(const secret_key& private_view_key,
+                      const public_key& public_spend_key);
+
+        bool
+        valid() const;
+
+        const public_key&
+        public_spend_key() const;
+
+        bool
+        generate_derivation(const public_key& pub_tx_key,
+                            key_derivation& derivation) const;
+
+        bool
+        derive_public_key(const key_derivation& derivation,
+                          size_t output_index,
+                          public_key& derived_key) const;
+
+        bool
+        is_output_ours(const key_derivation& derivation,
+                       size_t output_index,
+                       const public_key& output_pubkey) const;
+    };
+
+
+    array<double, 2>
+    benchmark_output_scanner(size_t output_no);
+
+}
+
+#endif //XMREG01_OUTPUTSCANNER_H
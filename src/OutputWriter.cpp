@@ -0,0 +1,241 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "OutputWriter.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+
+
+namespace xmreg
+{
+
+    const size_t OutputWriter::DEFAULT_CAPACITY;
+
+
+    /**
+     * Start the writer thread. Capacity is rounded
+     * up to a power of two.
+     */
+    OutputWriter::OutputWriter(int fd, size_t capacity)
+            : m_fd {fd}
+    {
+        m_capacity = 4096;
+
+        while (m_capacity < capacity)
+        {
+            m_capacity *= 2;
+        }
+
+        m_buffer.reset(new char[m_capacity]);
+
+        m_writer = thread {&OutputWriter::drain, this};
+    }
+
+
+    /**
+     * Copy data into the buffer, waiting for the writer
+     * thread if there is not enough free space
+     */
+    void
+    OutputWriter::write(const char* data, size_t size)
+    {
+        size_t head = m_head.load(memory_order_relaxed);
+
+        while (size > 0 && !m_failed)
+        {
+            size_t free_size = m_capacity - (head - m_tail.load(memory_order_acquire));
+
+            if (free_size == 0)
+            {
+                unique_lock<mutex> lock {m_sleep_mutex};
+
+                m_producer_sleeping = true;
+
+                m_producer_wakeup.wait(lock, [&]
+                {
+                    return head != m_tail.load() + m_capacity || m_failed;
+                });
+
+                m_producer_sleeping = false;
+
+                continue;
+            }
+
+            size_t offset = head & (m_capacity - 1);
+
+            // up to the end of the buffer, the rest on next pass
+            size_t copy_size = min(min(size, free_size), m_capacity - offset);
+
+            memcpy(m_buffer.get() + offset, data, copy_size);
+
+            data += copy_size;
+            size -= copy_size;
+            head += copy_size;
+
+            m_head.store(head);
+
+            wake_writer();
+        }
+    }
+
+
+    /**
+     * Wait until everything written so far is out
+     */
+    void
+    OutputWriter::flush()
+    {
+        size_t head = m_head.load(memory_order_relaxed);
+
+        unique_lock<mutex> lock {m_sleep_mutex};
+
+        m_producer_sleeping = true;
+
+        m_producer_wakeup.wait(lock, [&]
+        {
+            return m_tail.load() == head || m_failed;
+        });
+
+        m_producer_sleeping = false;
+    }
+
+
+    /**
+     * Write out what is left and stop the writer thread
+     */
+    void
+    OutputWriter::close()
+    {
+        if (!m_writer.joinable())
+        {
+            return;
+        }
+
+        m_closed = true;
+
+        {
+            lock_guard<mutex> lock {m_sleep_mutex};
+            m_writer_wakeup.notify_one();
+        }
+
+        m_writer.join();
+    }
+
+
+    /**
+     * Whether writing failed, e.g., the pipe
+     * was closed. Output is dropped after that.
+     */
+    bool
+    OutputWriter::failed() const
+    {
+        return m_failed;
+    }
+
+
+    OutputWriter::~OutputWriter()
+    {
+        close();
+    }
+
+
+    /**
+     * Body of the writer thread: write out contiguous
+     * parts of the buffer until closed and empty
+     */
+    void
+    OutputWriter::drain()
+    {
+        size_t tail = m_tail.load(memory_order_relaxed);
+
+        while (true)
+        {
+            size_t head = m_head.load(memory_order_acquire);
+
+            if (head == tail)
+            {
+                unique_lock<mutex> lock {m_sleep_mutex};
+
+                m_writer_sleeping = true;
+
+                m_writer_wakeup.wait(lock, [&]
+                {
+                    return m_head.load() != tail || m_closed;
+                });
+
+                m_writer_sleeping = false;
+
+                if (m_head.load() == tail)
+                {
+                    // closed, and nothing left
+                    return;
+                }
+
+                continue;
+            }
+
+            size_t offset = tail & (m_capacity - 1);
+
+            size_t write_size = min(head - tail, m_capacity - offset);
+
+            ssize_t written = ::write(m_fd, m_buffer.get() + offset, write_size);
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                cerr << "Cant write output: " << strerror(errno) << endl;
+
+                m_failed = true;
+
+                wake_producer();
+
+                return;
+            }
+
+            tail += written;
+
+            m_tail.store(tail);
+
+            wake_producer();
+        }
+    }
+
+
+    /**
+     * Notify only if the other side sleeps. It sets its flag
+     * before checking for data, and both flags and positions
+     * are sequentially consistent, so either it sees the new
+     * position, or we see the flag and notify under the lock,
+     * after it started waiting.
+     */
+    void
+    OutputWriter::wake_writer()
+    {
+        if (m_writer_sleeping)
+        {
+            lock_guard<mutex> lock {m_sleep_mutex};
+            m_writer_wakeup.notify_one();
+        }
+    }
+
+    void
+    OutputWriter::wake_producer()
+    {
+        if (m_producer_sleeping)
+        {
+            lock_guard<mutex> lock {m_sleep_mutex};
+            m_producer_wakeup.notify_one();
+        }
+    }
+
+}
@@ -0,0 +1,98 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_OUTPUTWRITER_H
+#define XMREG01_OUTPUTWRITER_H
+
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+namespace xmreg
+{
+    using namespace std;
+
+
+    /**
+     * Writes output to a file descriptor, e.g., stdout,
+     * on its own thread, so that a slow terminal or pipe
+     * does not stall the thread producing the output.
+     *
+     * Formatted chunks are copied into a ring buffer shared
+     * by one producer and the writer thread. The positions
+     * of both are atomics, so passing data takes no locks.
+     * The mutex is only used to sleep when the buffer is
+     * empty, or full, and only if the other side is asleep.
+     *
+     * The writer thread drains the buffer with as large
+     * write(2) calls as possible.
+     *
+     * write() must be called from one thread only.
+     */
+    class OutputWriter
+    {
+        static const size_t DEFAULT_CAPACITY = 1 << 20;
+
+        int m_fd;
+
+        unique_ptr<char[]> m_buffer;
+        size_t             m_capacity;
+
+        // total number of bytes put in and written out,
+        // positions in the buffer are these modulo capacity
+        atomic<size_t> m_head {0};
+        atomic<size_t> m_tail {0};
+
+        atomic<bool> m_closed {false};
+        atomic<bool> m_failed {false};
+
+        // whether writer or producer waits for the other one
+        atomic<bool> m_writer_sleeping {false};
+        atomic<bool> m_producer_sleeping {false};
+
+        mutex              m_sleep_mutex;
+        condition_variable m_writer_wakeup;
+        condition_variable m_producer_wakeup;
+
+        thread m_writer;
+
+    public:
+
+        explicit OutputWriter(int fd, size_t capacity = DEFAULT_CAPACITY);
+
+        OutputWriter(const OutputWriter&) = delete;
+        OutputWriter& operator=(const OutputWriter&) = delete;
+
+        void
+        write(const char* data, size_t size);
+
+        void
+        flush();
+
+        void
+        close();
+
+        bool
+        failed() const;
+
+        ~OutputWriter();
+
+    private:
+
+        void
+        drain();
+
+        void
+        wake_writer();
+
+        void
+        wake_producer();
+    };
+
+}
+
+#endif //XMREG01_OUTPUTWRITER_H
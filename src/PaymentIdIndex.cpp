@@ -0,0 +1,321 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "PaymentIdIndex.h"
+#include "chain_scan.h"
+#include "tx_details.h"
+
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        const char PAYMENT_ID_INDEX_MAGIC[8] {'X', 'M', 'R', 'P', 'A', 'Y', 'I', 'D'};
+
+        const uint64_t PAYMENT_ID_INDEX_VERSION {1};
+
+        // number of blocks each thread reads at a time
+        const uint64_t INDEX_CHUNK_SIZE {10000};
+
+        struct payment_id_index_header
+        {
+            char     magic[8];
+            uint64_t version;
+            uint64_t from_height;
+            uint64_t to_height;
+            uint64_t payment_id_no;
+            uint64_t encrypted_id_no;
+        };
+
+        // txs with payment ids found by a single chunk of blocks
+        struct chunk_ids
+        {
+            vector<crypto::hash>  payment_ids;
+            vector<payment_id_tx> txs;
+            vector<crypto::hash8> encrypted_ids;
+            vector<payment_id_tx> encrypted_txs;
+        };
+
+        template <typename ID>
+        inline bool
+        id_less(const ID& a, const ID& b)
+        {
+            return memcmp(&a, &b, sizeof(ID)) < 0;
+        }
+
+
+        /**
+         * Sort ids, and their txs along with them. Sorting
+         * is stable, so txs of the same id stay in height order.
+         */
+        template <typename ID>
+        void
+        sort_ids(vector<ID>& ids, vector<payment_id_tx>& txs)
+        {
+            vector<size_t> order(ids.size());
+
+            iota(order.begin(), order.end(), 0);
+
+            stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+            {
+                return id_less(ids[a], ids[b]);
+            });
+
+            vector<ID>            sorted_ids(ids.size());
+            vector<payment_id_tx> sorted_txs(txs.size());
+
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                sorted_ids[i] = ids[order[i]];
+                sorted_txs[i] = txs[order[i]];
+            }
+
+            ids.swap(sorted_ids);
+            txs.swap(sorted_txs);
+        }
+
+
+        /**
+         * Txs of the given id, found with binary search
+         */
+        template <typename ID>
+        array_view<payment_id_tx>
+        find_id(const array_view<ID>& ids,
+                const array_view<payment_id_tx>& txs,
+                const ID& id)
+        {
+            auto range = equal_range(ids.begin(), ids.end(), id, id_less<ID>);
+
+            return array_view<payment_id_tx> {
+                    txs.begin() + (range.first - ids.begin()),
+                    static_cast<size_t>(range.second - range.first)};
+        }
+    }
+
+
+    /**
+     * Find payment ids of all txs in the given height range
+     * and index them. Blocks are read in parallel, in chunks,
+     * and tx extras are parsed once for both kinds of ids.
+     *
+     * returns false if the scan was stopped by a signal
+     */
+    bool
+    PaymentIdIndex::build(MicroCore& mcore,
+                          uint64_t from_height,
+                          uint64_t to_height,
+                          size_t thread_no)
+    {
+        vector<chunk_ids> chunks(get_chunk_no(from_height, to_height, INDEX_CHUNK_SIZE));
+
+        bool completed = parallel_scan_blocks(
+                mcore, from_height, to_height, INDEX_CHUNK_SIZE,
+                [&](size_t chunk_idx, uint64_t blk_height,
+                    const block&, const list<transaction>& txs)
+        {
+            chunk_ids& chunk = chunks[chunk_idx];
+
+            tx_payment_ids payment_ids;
+
+            for (const transaction& tx: txs)
+            {
+                if (!get_payment_ids(tx, payment_ids))
+                {
+                    continue;
+                }
+
+                payment_id_tx id_tx {get_transaction_hash(tx), blk_height};
+
+                if (payment_ids.has_encrypted_payment_id)
+                {
+                    chunk.encrypted_ids.push_back(payment_ids.encrypted_payment_id);
+                    chunk.encrypted_txs.push_back(id_tx);
+                }
+                else
+                {
+                    chunk.payment_ids.push_back(payment_ids.payment_id);
+                    chunk.txs.push_back(id_tx);
+                }
+            }
+        }, thread_no);
+
+        if (!completed)
+        {
+            return false;
+        }
+
+        m_payment_ids_vec.clear();
+        m_txs_vec.clear();
+        m_encrypted_ids_vec.clear();
+        m_encrypted_txs_vec.clear();
+
+        // merge the chunks in height order
+        for (chunk_ids& chunk: chunks)
+        {
+            m_payment_ids_vec.insert(m_payment_ids_vec.end(),
+                                     chunk.payment_ids.begin(), chunk.payment_ids.end());
+            m_txs_vec.insert(m_txs_vec.end(),
+                             chunk.txs.begin(), chunk.txs.end());
+            m_encrypted_ids_vec.insert(m_encrypted_ids_vec.end(),
+                                       chunk.encrypted_ids.begin(), chunk.encrypted_ids.end());
+            m_encrypted_txs_vec.insert(m_encrypted_txs_vec.end(),
+                                       chunk.encrypted_txs.begin(), chunk.encrypted_txs.end());
+
+            // free memory of merged chunk as we go
+            chunk = chunk_ids {};
+        }
+
+        sort_ids(m_payment_ids_vec, m_txs_vec);
+        sort_ids(m_encrypted_ids_vec, m_encrypted_txs_vec);
+
+        m_from_height = from_height;
+        m_to_height   = to_height;
+
+        m_file.close();
+
+        m_payment_ids   = {m_payment_ids_vec.data(), m_payment_ids_vec.size()};
+        m_txs           = {m_txs_vec.data(), m_txs_vec.size()};
+        m_encrypted_ids = {m_encrypted_ids_vec.data(), m_encrypted_ids_vec.size()};
+        m_encrypted_txs = {m_encrypted_txs_vec.data(), m_encrypted_txs_vec.size()};
+
+        return true;
+    }
+
+
+    /**
+     * Save the index into a binary file, which can
+     * be later memory mapped using load().
+     */
+    bool
+    PaymentIdIndex::save(const string& file_path) const
+    {
+        ofstream out {file_path, ios::binary | ios::trunc};
+
+        if (!out)
+        {
+            cerr << "Cant write payment id index: " << file_path << endl;
+            return false;
+        }
+
+        payment_id_index_header header;
+
+        memcpy(header.magic, PAYMENT_ID_INDEX_MAGIC, sizeof(header.magic));
+
+        header.version         = PAYMENT_ID_INDEX_VERSION;
+        header.from_height     = m_from_height;
+        header.to_height       = m_to_height;
+        header.payment_id_no   = m_payment_ids.size();
+        header.encrypted_id_no = m_encrypted_ids.size();
+
+        write_padded_array(out, &header, 1);
+        write_padded_array(out, m_payment_ids.begin(), m_payment_ids.size());
+        write_padded_array(out, m_txs.begin(), m_txs.size());
+        write_padded_array(out, m_encrypted_ids.begin(), m_encrypted_ids.size());
+        write_padded_array(out, m_encrypted_txs.begin(), m_encrypted_txs.size());
+
+        if (!out.flush())
+        {
+            cerr << "Cant write payment id index: " << file_path << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Memory map the index saved with save()
+     */
+    bool
+    PaymentIdIndex::load(const string& file_path)
+    {
+        if (!m_file.open(file_path))
+        {
+            return false;
+        }
+
+        if (m_file.size() < sizeof(payment_id_index_header))
+        {
+            cerr << "Payment id index file too short: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        payment_id_index_header header;
+        memcpy(&header, m_file.data(), sizeof(header));
+
+        if (memcmp(header.magic, PAYMENT_ID_INDEX_MAGIC, sizeof(header.magic)) != 0
+            || header.version != PAYMENT_ID_INDEX_VERSION)
+        {
+            cerr << "Not a payment id index file: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        size_t offset = padded_size(sizeof(payment_id_index_header));
+
+        if (!map_padded_array(m_file, offset, header.payment_id_no, m_payment_ids)
+            || !map_padded_array(m_file, offset, header.payment_id_no, m_txs)
+            || !map_padded_array(m_file, offset, header.encrypted_id_no, m_encrypted_ids)
+            || !map_padded_array(m_file, offset, header.encrypted_id_no, m_encrypted_txs))
+        {
+            cerr << "Payment id index file is truncated: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        m_from_height = header.from_height;
+        m_to_height   = header.to_height;
+
+        // free memory of previously built index
+        m_payment_ids_vec   = vector<crypto::hash> {};
+        m_txs_vec           = vector<payment_id_tx> {};
+        m_encrypted_ids_vec = vector<crypto::hash8> {};
+        m_encrypted_txs_vec = vector<payment_id_tx> {};
+
+        return true;
+    }
+
+
+    uint64_t
+    PaymentIdIndex::from_height() const
+    {
+        return m_from_height;
+    }
+
+    uint64_t
+    PaymentIdIndex::to_height() const
+    {
+        return m_to_height;
+    }
+
+    size_t
+    PaymentIdIndex::tx_no() const
+    {
+        return m_txs.size() + m_encrypted_txs.size();
+    }
+
+
+    /**
+     * Get txs with the given payment id, in height order
+     */
+    array_view<payment_id_tx>
+    PaymentIdIndex::find(const crypto::hash& payment_id) const
+    {
+        return find_id(m_payment_ids, m_txs, payment_id);
+    }
+
+    array_view<payment_id_tx>
+    PaymentIdIndex::find(const crypto::hash8& encrypted_payment_id) const
+    {
+        return find_id(m_encrypted_ids, m_encrypted_txs, encrypted_payment_id);
+    }
+
+}
@@ -0,0 +1,93 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_PAYMENTIDINDEX_H
+#define XMREG01_PAYMENTIDINDEX_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Tx with a given payment id, and its block height
+     */
+    struct payment_id_tx
+    {
+        crypto::hash tx_hash;
+        uint64_t     blk_height;
+    };
+
+
+    /**
+     * Index of txs by their payment ids, for a given
+     * height range, e.g., to find deposits to an exchange.
+     *
+     * Normal and encrypted payment ids are kept separately,
+     * each as a sorted array of ids with a parallel array of
+     * their txs. Many txs can have the same id, and these are
+     * in height order. As other indices of this program, it
+     * can be saved and later memory mapped.
+     */
+    class PaymentIdIndex
+    {
+        uint64_t m_from_height {0};
+        uint64_t m_to_height {0};
+
+        // storage for the arrays, when built in memory
+        vector<crypto::hash>  m_payment_ids_vec;
+        vector<payment_id_tx> m_txs_vec;
+        vector<crypto::hash8> m_encrypted_ids_vec;
+        vector<payment_id_tx> m_encrypted_txs_vec;
+
+        // storage for the arrays, when loaded from a file
+        MappedFile m_file;
+
+        array_view<crypto::hash>  m_payment_ids;
+        array_view<payment_id_tx> m_txs;
+        array_view<crypto::hash8> m_encrypted_ids;
+        array_view<payment_id_tx> m_encrypted_txs;
+
+    public:
+
+        bool
+        build(MicroCore& mcore,
+              uint64_t from_height,
+              uint64_t to_height,
+              size_t thread_no = 0);
+
+        bool
+        save(const string& file_path) const;
+
+        bool
+        load(const string& file_path);
+
+        uint64_t
+        from_height() const;
+
+        uint64_t
+        to_height() const;
+
+        size_t
+        tx_no() const;
+
+        array_view<payment_id_tx>
+        find(const crypto::hash& payment_id) const;
+
+        array_view<payment_id_tx>
+        find(const crypto::hash8& encrypted_payment_id) const;
+    };
+
+}
+
+#endif //XMREG01_PAYMENTIDINDEX_H
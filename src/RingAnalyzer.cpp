@@ -0,0 +1,361 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "RingAnalyzer.h"
+
+
+namespace xmreg
+{
+
+    /**
+     * Start counting growth of the vectors for a new
+     * tx. Vectors keep their memory for reuse.
+     */
+    void
+    analysis_scratch::reset()
+    {
+        growth_no    = 0;
+        growth_bytes = 0;
+    }
+
+
+    RingAnalyzer::RingAnalyzer(MicroCore& mcore,
+                               const OutputScanner* scanner,
+                               const AccountSet* accounts)
+            : m_mcore {mcore}, m_scanner {scanner}, m_accounts {accounts}
+    {}
+
+
+    /**
+     * Get transaction of given hash and the
+     * basic information about it, e.g., its payment id.
+     *
+     * returns false if the tx was not found
+     */
+    bool
+    RingAnalyzer::analyze_header(const crypto::hash& tx_hash,
+                                 transaction& tx,
+                                 tx_header_details& hdr) const
+    {
+        Blockchain& core_storage = m_mcore.get_core();
+
+        try
+        {
+            // get transaction with given hash
+            tx = core_storage.get_db().get_tx(tx_hash);
+
+            // get block height in which the given transaction is located
+            hdr.blk_height = core_storage.get_db().get_tx_block_height(tx_hash);
+        }
+        catch (const std::exception& e)
+        {
+            cerr << e.what() << endl;
+            return false;
+        }
+
+        hdr.tx_hash  = tx_hash;
+        hdr.input_no = tx.vin.size();
+
+        find_payment_id(tx, hdr);
+
+        return true;
+    }
+
+
+    /**
+     * Get tx payment id if present.
+     * Checks for encrypted id first, and then for normal.
+     */
+    void
+    RingAnalyzer::find_payment_id(const transaction& tx,
+                                  tx_header_details& hdr) const
+    {
+        tx_payment_ids payment_ids;
+
+        get_payment_ids(tx, payment_ids);
+
+        hdr.has_encrypted_payment_id = payment_ids.has_encrypted_payment_id;
+        hdr.encrypted_payment_id     = payment_ids.encrypted_payment_id;
+
+        hdr.has_payment_id = payment_ids.has_payment_id;
+        hdr.payment_id     = payment_ids.payment_id;
+    }
+
+
+
+    /**
+     * Resolve all mixins of in_i input of the given transaction.
+     *
+     * For each mixin, we find the tx it comes from,
+     * its block and timestamp, and its global index.
+     * If the analyzer has a scanner with our private view key and
+     * public spend key, we also check if the mixin is ours. Similarly,
+     * if it has a set of accounts, we find which of them owns it.
+     *
+     * All blockchain access happens here, so that
+     * the results can be printed later without
+     * touching the database.
+     *
+     * Temporary vectors are taken from the scratch, if given,
+     * so that their memory is reused instead of being
+     * allocated again for each input.
+     *
+     * returns false for coinbase inputs
+     */
+    bool
+    RingAnalyzer::analyze_input(const transaction& tx,
+                                size_t in_i,
+                                input_details& in_details,
+                                analysis_scratch* scratch) const
+    {
+        Blockchain& core_storage = m_mcore.get_core();
+
+        in_details = input_details {};
+
+        in_details.in_i = in_i;
+
+        const txin_v& tx_in = tx.vin[in_i];
+
+        if (tx_in.type() == typeid(txin_gen))
+        {
+            in_details.is_coinbase = true;
+            return false;
+        }
+
+        // get tx input key
+        const txin_to_key& tx_in_to_key
+                = boost::get<txin_to_key>(tx_in);
+
+        in_details.k_image = tx_in_to_key.k_image;
+        in_details.amount  = tx_in_to_key.amount;
+
+        if (in_i < tx.signatures.size())
+        {
+            in_details.signatures = tx.signatures[in_i];
+        }
+
+        // scratch vectors are reused between inputs and txs,
+        // if the caller gives them to us
+        analysis_scratch local_scratch;
+        analysis_scratch& s = scratch ? *scratch : local_scratch;
+
+        vector<uint64_t>&      absolute_offsets   = s.absolute_offsets;
+        vector<output_data_t>& outputs            = s.outputs;
+        vector<tx_out_index>&  tx_out_indices     = s.tx_out_indices;
+
+        size_t offsets_capacity = absolute_offsets.capacity();
+        size_t outputs_capacity = outputs.capacity();
+        size_t indices_capacity = tx_out_indices.capacity();
+
+        // get absolute offsets of mixins, same as
+        // relative_output_offsets_to_absolute, but in place
+        absolute_offsets.assign(tx_in_to_key.key_offsets.begin(),
+                                tx_in_to_key.key_offsets.end());
+
+        for (size_t i = 1; i < absolute_offsets.size(); ++i)
+        {
+            absolute_offsets[i] += absolute_offsets[i - 1];
+        }
+
+        outputs.clear();
+        core_storage.get_db().get_output_key(tx_in_to_key.amount,
+                                             absolute_offsets,
+                                             outputs);
+
+        // txs and local indices of all mixins at once, instead
+        // of searching blocks for txs with their output keys
+        tx_out_indices.clear();
+        core_storage.get_db().get_output_tx_and_index(tx_in_to_key.amount,
+                                                      absolute_offsets,
+                                                      tx_out_indices);
+
+        s.count_growth(absolute_offsets, offsets_capacity);
+        s.count_growth(outputs, outputs_capacity);
+        s.count_growth(tx_out_indices, indices_capacity);
+
+        in_details.mixins.reserve(absolute_offsets.size());
+        in_details.mixin_timestamps.reserve(absolute_offsets.size());
+
+        // tx of the current mixin, reused so that its
+        // vectors keep their capacity between mixins
+        transaction& tx_found = s.tx_found;
+
+        size_t count = 0;
+
+        for (size_t i = 0; i < absolute_offsets.size(); ++i)
+        {
+            // filled in place, so that it is not copied
+            in_details.mixins.emplace_back();
+
+            mixin_details& mixin = in_details.mixins.back();
+
+            mixin.mixin_no = count + 1;
+
+            output_data_t output_data;
+
+            // get tx hash and output index for output
+            if (count < outputs.size())
+            {
+                output_data = outputs.at(count);
+            }
+
+            mixin.out_pubkey   = output_data.pubkey;
+            mixin.block_height = output_data.height;
+
+            if (count >= tx_out_indices.size())
+            {
+                mixin.error = fmt::format(
+                        "- cant find tx_hash for ouput: {}, mixin no: {}, blk: {}\n",
+                        output_data.pubkey, count + 1, output_data.height);
+
+                continue;
+            }
+
+            // tx hash and local index of the output, as
+            // stored with its global index in the blockchain
+            const tx_out_index& out_index = tx_out_indices[count];
+
+            mixin.tx_hash      = out_index.first;
+            mixin.output_index = out_index.second;
+            mixin.global_index = absolute_offsets[count];
+
+            if (!m_mcore.get_tx(mixin.tx_hash, tx_found)
+                || mixin.output_index >= tx_found.vout.size())
+            {
+                mixin.error = fmt::format(
+                        "- cant find tx_out for ouput: {}, mixin no: {}, blk: {}\n",
+                        output_data.pubkey, count + 1, output_data.height);
+
+                continue;
+            }
+
+            mixin.amount = tx_found.vout[mixin.output_index].amount;
+
+            // only the timestamp of the block is read,
+            // not the whole block
+            if (!m_mcore.get_blk_timestamp(output_data.height, mixin.blk_timestamp))
+            {
+                mixin.error = fmt::format(
+                        "- cant get block of height: {}\n", output_data.height);
+
+                continue;
+            }
+
+            mixin.block_found = true;
+
+            // save mixin timestamp for later
+            in_details.mixin_timestamps.push_back(mixin.blk_timestamp);
+
+            if (m_scanner)
+            {
+                // check if the given mixin's output is ours based
+                // on the view key and public spend key from the address
+                mixin.is_ours = is_output_ours(mixin.output_index, tx_found,
+                                               *m_scanner);
+            }
+
+            if (m_accounts)
+            {
+                mixin.owners = m_accounts->get_output_owners(tx_found,
+                                                             mixin.output_index);
+            }
+
+            // get tx public key from extras field
+            mixin.tx_pub_key = read_tx_pub_key(tx_found);
+
+            ++count;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Analyze all inputs of the tx, counting
+     * growth of the scratch vectors, if given
+     */
+    void
+    RingAnalyzer::analyze_inputs(const transaction& tx,
+                                 tx_analysis& result,
+                                 analysis_scratch* scratch) const
+    {
+        if (scratch)
+        {
+            scratch->reset();
+        }
+
+        result.inputs.resize(tx.vin.size());
+
+        for (size_t in_i = 0; in_i < tx.vin.size(); ++in_i)
+        {
+            analyze_input(tx, in_i, result.inputs[in_i], scratch);
+        }
+
+        if (scratch)
+        {
+            result.scratch_growth_no    = scratch->growth_no;
+            result.scratch_growth_bytes = scratch->growth_bytes;
+        }
+    }
+
+
+    /**
+     * Analyze transaction of the given hash
+     * and all its inputs.
+     *
+     * returns false if the tx was not found
+     */
+    bool
+    RingAnalyzer::analyze(const crypto::hash& tx_hash,
+                          tx_analysis& result,
+                          analysis_scratch* scratch) const
+    {
+        transaction tx;
+
+        result = tx_analysis {};
+
+        if (!analyze_header(tx_hash, tx, result.hdr))
+        {
+            return false;
+        }
+
+        analyze_inputs(tx, result, scratch);
+
+        return true;
+    }
+
+
+    /**
+     * Analyze the given transaction, e.g., one from a block
+     * being processed. Its height is left as 0 if the tx is not
+     * in the blockchain.
+     */
+    bool
+    RingAnalyzer::analyze(const transaction& tx,
+                          tx_analysis& result,
+                          analysis_scratch* scratch) const
+    {
+        result = tx_analysis {};
+
+        result.hdr.tx_hash  = get_transaction_hash(tx);
+        result.hdr.input_no = tx.vin.size();
+
+        try
+        {
+            result.hdr.blk_height = m_mcore.get_core().get_db()
+                    .get_tx_block_height(result.hdr.tx_hash);
+        }
+        catch (const std::exception&)
+        {
+            result.hdr.blk_height = 0;
+        }
+
+        find_payment_id(tx, result.hdr);
+
+        analyze_inputs(tx, result, scratch);
+
+        return true;
+    }
+
+}
@@ -0,0 +1,199 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_RINGANALYZER_H
+#define XMREG01_RINGANALYZER_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "tools.h"
+#include "AccountSet.h"
+
+#include "../ext/format.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Everything we know about a single mixin (ring member)
+     * of an input, as resolved from the blockchain.
+     *
+     * If some lookup failed, error contains the message to
+     * show, and block_found tells if the mixin's block,
+     * and thus its timestamp, was resolved before that.
+     */
+    struct mixin_details
+    {
+        size_t       mixin_no {0};
+        uint64_t     block_height {0};
+        uint64_t     blk_timestamp {0};
+        public_key   out_pubkey;
+        crypto::hash tx_hash;
+        public_key   tx_pub_key;
+        size_t       output_index {0};
+        uint64_t     global_index {0};
+        uint64_t     amount {0};
+        bool         is_ours {false};
+        vector<size_t> owners;
+        bool         block_found {false};
+        string       error;
+    };
+
+
+    /**
+     * Resolved input of a transaction, i.e., its key image,
+     * all its mixins and its ring signature.
+     */
+    struct input_details
+    {
+        size_t                in_i {0};
+        bool                  is_coinbase {false};
+        key_image             k_image;
+        uint64_t              amount {0};
+        vector<mixin_details> mixins;
+        vector<uint64_t>      mixin_timestamps;
+        vector<signature>     signatures;
+    };
+
+
+    /**
+     * Basic information about a transaction,
+     * e.g., its payment id
+     */
+    struct tx_header_details
+    {
+        crypto::hash tx_hash;
+        uint64_t     blk_height {0};
+        bool         has_payment_id {false};
+        bool         has_encrypted_payment_id {false};
+        crypto::hash payment_id;
+        crypto::hash8 encrypted_payment_id;
+        size_t       input_no {0};
+    };
+
+
+    /**
+     * Resolved transaction, i.e., its header
+     * and all its inputs, in order
+     */
+    struct tx_analysis
+    {
+        tx_header_details     hdr;
+        vector<input_details> inputs;
+
+        // times the scratch vectors had to grow during
+        // the analysis, and their new sizes in bytes,
+        // if a scratch was used. Other allocations,
+        // e.g., of the read txs, are not counted.
+        size_t scratch_growth_no {0};
+        size_t scratch_growth_bytes {0};
+    };
+
+
+    /**
+     * Scratch memory of the ring lookups of a single thread.
+     *
+     * Vectors passed to the blockchain functions, and the tx
+     * of the current mixin, are kept here between inputs and
+     * txs, so that they keep their capacity, and after warming
+     * up, no heap allocations are made for them.
+     * Times the vectors had to grow are counted
+     * since the last reset().
+     */
+    struct analysis_scratch
+    {
+        vector<uint64_t>      absolute_offsets;
+        vector<output_data_t> outputs;
+        vector<tx_out_index>  tx_out_indices;
+        transaction           tx_found;
+
+        size_t growth_no {0};
+        size_t growth_bytes {0};
+
+        void
+        reset();
+
+        template <typename T>
+        void
+        count_growth(const vector<T>& v, size_t old_capacity)
+        {
+            if (v.capacity() != old_capacity)
+            {
+                ++growth_no;
+                growth_bytes += v.capacity() * sizeof(T);
+            }
+        }
+    };
+
+
+    /**
+     * Resolves rings of transactions' inputs, i.e., blocks,
+     * timestamps, global indices and owners of their members,
+     * into plain structures, without printing anything.
+     *
+     * Whole transactions can be analyzed at once, or input
+     * by input, e.g., to show the first inputs while
+     * the next ones are still being looked up.
+     *
+     * Only reads the blockchain, so a single analyzer can
+     * be used by many threads at the same time.
+     */
+    class RingAnalyzer
+    {
+        MicroCore& m_mcore;
+
+        // to check if mixins are ours, if given
+        const OutputScanner* m_scanner;
+
+        // to find owners of mixins, if given
+        const AccountSet* m_accounts;
+
+    public:
+
+        RingAnalyzer(MicroCore& mcore,
+                     const OutputScanner* scanner = nullptr,
+                     const AccountSet* accounts = nullptr);
+
+        bool
+        analyze_header(const crypto::hash& tx_hash,
+                       transaction& tx,
+                       tx_header_details& hdr) const;
+
+        bool
+        analyze_input(const transaction& tx,
+                      size_t in_i,
+                      input_details& in_details,
+                      analysis_scratch* scratch = nullptr) const;
+
+        bool
+        analyze(const crypto::hash& tx_hash,
+                tx_analysis& result,
+                analysis_scratch* scratch = nullptr) const;
+
+        bool
+        analyze(const transaction& tx,
+                tx_analysis& result,
+                analysis_scratch* scratch = nullptr) const;
+
+    private:
+
+        void
+        find_payment_id(const transaction& tx, tx_header_details& hdr) const;
+
+        void
+        analyze_inputs(const transaction& tx,
+                       tx_analysis& result,
+                       analysis_scratch* scratch) const;
+    };
+
+}
+
+#endif //XMREG01_RINGANALYZER_H
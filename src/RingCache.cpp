@@ -0,0 +1,441 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "RingCache.h"
+#include "parallel.h"
+
+#include "common/varint.h"
+
+#include <map>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        const char RING_CACHE_MAGIC[8] {'X', 'M', 'R', 'R', 'C', 'A', 'C', 'H'};
+
+        const uint64_t RING_CACHE_VERSION {1};
+
+        // number of blockchain blocks in one block of rings
+        const uint64_t RING_CACHE_BLOCK_SIZE {1000};
+
+        struct ring_cache_header
+        {
+            char     magic[8];
+            uint64_t version;
+            uint64_t from_height;
+            uint64_t to_height;
+            uint64_t amount_no;
+            uint64_t block_no;
+            uint64_t data_size;
+        };
+
+        // block of rings being encoded
+        struct encoded_block
+        {
+            ring_cache_block         info;
+            uint64_t                 last_ring_height;
+            string                   data;
+            map<uint64_t, uint64_t>  output_nos;
+        };
+
+        void
+        write_value(string& data, uint64_t value)
+        {
+            tools::write_varint(back_inserter(data), value);
+        }
+
+        bool
+        read_value(const unsigned char*& first,
+                   const unsigned char* last,
+                   uint64_t& value)
+        {
+            return tools::read_varint(first, last, value) > 0;
+        }
+
+        void
+        encode_ring(const input_ring& ring, encoded_block& blk)
+        {
+            write_value(blk.data, ring.blk_height - blk.last_ring_height);
+
+            blk.data.append(reinterpret_cast<const char*>(&ring.k_image),
+                            sizeof(key_image));
+
+            write_value(blk.data, ring.amount);
+            write_value(blk.data, ring.absolute_offsets.size());
+
+            uint64_t prev_offset {0};
+
+            for (uint64_t offset: ring.absolute_offsets)
+            {
+                write_value(blk.data, offset - prev_offset);
+                prev_offset = offset;
+            }
+
+            for (uint64_t member_height: ring.member_heights)
+            {
+                write_value(blk.data, ring.blk_height - member_height);
+            }
+
+            blk.last_ring_height = ring.blk_height;
+        }
+
+        bool
+        decode_ring(const unsigned char*& first,
+                    const unsigned char* last,
+                    uint64_t prev_height,
+                    input_ring& ring)
+        {
+            uint64_t height_delta, ring_size;
+
+            if (!read_value(first, last, height_delta)
+                || last - first < static_cast<ptrdiff_t>(sizeof(key_image)))
+            {
+                return false;
+            }
+
+            ring.blk_height = prev_height + height_delta;
+
+            memcpy(&ring.k_image, first, sizeof(key_image));
+            first += sizeof(key_image);
+
+            if (!read_value(first, last, ring.amount)
+                || !read_value(first, last, ring_size)
+                || ring_size > static_cast<uint64_t>(last - first))
+            {
+                return false;
+            }
+
+            ring.absolute_offsets.resize(ring_size);
+            ring.member_heights.resize(ring_size);
+
+            uint64_t offset {0};
+
+            for (uint64_t& absolute_offset: ring.absolute_offsets)
+            {
+                uint64_t delta;
+
+                if (!read_value(first, last, delta))
+                {
+                    return false;
+                }
+
+                offset += delta;
+                absolute_offset = offset;
+            }
+
+            for (uint64_t& member_height: ring.member_heights)
+            {
+                uint64_t delta;
+
+                if (!read_value(first, last, delta))
+                {
+                    return false;
+                }
+
+                member_height = ring.blk_height - delta;
+            }
+
+            return true;
+        }
+    }
+
+
+    /**
+     * Extract rings of all inputs in the given height range,
+     * together with heights of their members, and save them
+     * into the cache file.
+     *
+     * Blocks of rings are encoded in parallel, each one
+     * separately, and written in height order at the end.
+     */
+    bool
+    RingCache::build(MicroCore& mcore,
+                     uint64_t from_height,
+                     uint64_t to_height,
+                     const string& file_path,
+                     size_t thread_no)
+    {
+        ChainRingSource source {mcore, from_height, to_height,
+                                RING_CACHE_BLOCK_SIZE, true};
+
+        vector<encoded_block> blocks(source.chunk_no());
+
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            ring_cache_block& info = blocks[i].info;
+
+            info.first_height = from_height + i * RING_CACHE_BLOCK_SIZE;
+            info.last_height  = min(to_height, info.first_height + RING_CACHE_BLOCK_SIZE - 1);
+            info.input_no     = 0;
+
+            blocks[i].last_ring_height = info.first_height;
+        }
+
+        bool completed = source.scan([&](size_t chunk_idx, const input_ring& ring)
+        {
+            encoded_block& blk = blocks[chunk_idx];
+
+            encode_ring(ring, blk);
+
+            ++blk.info.input_no;
+
+            if (!ring.absolute_offsets.empty())
+            {
+                uint64_t& output_no = blk.output_nos[ring.amount];
+                output_no = max(output_no, ring.absolute_offsets.back() + 1);
+            }
+        }, thread_no);
+
+        if (!completed)
+        {
+            return false;
+        }
+
+        map<uint64_t, uint64_t> output_nos;
+
+        uint64_t data_size {0};
+
+        for (encoded_block& blk: blocks)
+        {
+            for (const auto& amount_output_no: blk.output_nos)
+            {
+                uint64_t& output_no = output_nos[amount_output_no.first];
+                output_no = max(output_no, amount_output_no.second);
+            }
+
+            blk.info.offset = data_size;
+            blk.info.size   = blk.data.size();
+
+            data_size += blk.data.size();
+        }
+
+        vector<uint64_t> amounts;
+        vector<uint64_t> amount_output_nos;
+
+        for (const auto& amount_output_no: output_nos)
+        {
+            amounts.push_back(amount_output_no.first);
+            amount_output_nos.push_back(amount_output_no.second);
+        }
+
+        vector<ring_cache_block> index;
+
+        for (const encoded_block& blk: blocks)
+        {
+            index.push_back(blk.info);
+        }
+
+        ofstream out {file_path, ios::binary | ios::trunc};
+
+        if (!out)
+        {
+            cerr << "Cant write ring cache: " << file_path << endl;
+            return false;
+        }
+
+        ring_cache_header header;
+
+        memcpy(header.magic, RING_CACHE_MAGIC, sizeof(header.magic));
+
+        header.version     = RING_CACHE_VERSION;
+        header.from_height = from_height;
+        header.to_height   = to_height;
+        header.amount_no   = amounts.size();
+        header.block_no    = index.size();
+        header.data_size   = data_size;
+
+        write_padded_array(out, &header, 1);
+        write_padded_array(out, amounts.data(), amounts.size());
+        write_padded_array(out, amount_output_nos.data(), amount_output_nos.size());
+        write_padded_array(out, index.data(), index.size());
+
+        for (const encoded_block& blk: blocks)
+        {
+            out.write(blk.data.data(), blk.data.size());
+        }
+
+        if (!out.flush())
+        {
+            cerr << "Cant write ring cache: " << file_path << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Memory map the cache file. All rings in it are
+     * selected, until select() is called.
+     */
+    bool
+    RingCache::load(const string& file_path)
+    {
+        if (!m_file.open(file_path))
+        {
+            return false;
+        }
+
+        ring_cache_header header;
+
+        if (m_file.size() < sizeof(header))
+        {
+            cerr << "Ring cache file too short: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        memcpy(&header, m_file.data(), sizeof(header));
+
+        if (memcmp(header.magic, RING_CACHE_MAGIC, sizeof(header.magic)) != 0
+            || header.version != RING_CACHE_VERSION)
+        {
+            cerr << "Not a ring cache file: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        size_t offset = padded_size(sizeof(header));
+
+        if (!map_padded_array(m_file, offset, header.amount_no, m_amounts)
+            || !map_padded_array(m_file, offset, header.amount_no, m_amount_output_nos)
+            || !map_padded_array(m_file, offset, header.block_no, m_blocks)
+            || !map_padded_array(m_file, offset, header.data_size, m_data))
+        {
+            cerr << "Ring cache file is truncated: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        m_from_height = header.from_height;
+        m_to_height   = header.to_height;
+
+        select(m_from_height, m_to_height);
+
+        return true;
+    }
+
+
+    /**
+     * Limit rings given by scan() to the given height range,
+     * within the range of the cache.
+     */
+    void
+    RingCache::select(uint64_t from_height, uint64_t to_height)
+    {
+        m_scan_from = max(from_height, m_from_height);
+        m_scan_to   = min(to_height, m_to_height);
+    }
+
+
+    uint64_t
+    RingCache::from_height() const
+    {
+        return m_scan_from;
+    }
+
+    uint64_t
+    RingCache::to_height() const
+    {
+        return m_scan_to;
+    }
+
+    size_t
+    RingCache::chunk_no() const
+    {
+        return m_blocks.size();
+    }
+
+
+    uint64_t
+    RingCache::output_no(uint64_t amount) const
+    {
+        const uint64_t* it = lower_bound(m_amounts.begin(), m_amounts.end(), amount);
+
+        if (it == m_amounts.end() || *it != amount)
+        {
+            return 0;
+        }
+
+        return m_amount_output_nos[it - m_amounts.begin()];
+    }
+
+
+    /**
+     * Decode blocks of rings in parallel, in the same way
+     * parallel_scan_blocks reads blockchain blocks. Each block
+     * of rings is one chunk.
+     *
+     * returns false if the scan was stopped by a signal
+     * or the cache is corrupted
+     */
+    bool
+    RingCache::scan(const chunk_ring_processor& process_ring,
+                    size_t thread_no) const
+    {
+        atomic<size_t> next_block {0};
+        atomic<bool> corrupted {false};
+
+        parallel_chunks(get_thread_no(thread_no), [&](size_t, size_t, size_t)
+        {
+            input_ring ring {};
+
+            size_t block_idx;
+
+            while ((block_idx = next_block++) < m_blocks.size() && !stop_requested())
+            {
+                const ring_cache_block& blk = m_blocks[block_idx];
+
+                if (blk.last_height < m_scan_from || blk.first_height > m_scan_to)
+                {
+                    continue;
+                }
+
+                if (blk.offset + blk.size > m_data.size())
+                {
+                    corrupted = true;
+                    return;
+                }
+
+                const unsigned char* first = m_data.begin() + blk.offset;
+                const unsigned char* last  = first + blk.size;
+
+                uint64_t prev_height = blk.first_height;
+
+                for (uint64_t i = 0; i < blk.input_no; ++i)
+                {
+                    if (!decode_ring(first, last, prev_height, ring))
+                    {
+                        corrupted = true;
+                        return;
+                    }
+
+                    prev_height = ring.blk_height;
+
+                    if (ring.blk_height >= m_scan_from && ring.blk_height <= m_scan_to)
+                    {
+                        process_ring(block_idx, ring);
+                    }
+                }
+            }
+        }, thread_no);
+
+        if (corrupted)
+        {
+            cerr << "Ring cache is corrupted." << endl;
+            return false;
+        }
+
+        return !stop_requested();
+    }
+
+}
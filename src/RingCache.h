@@ -0,0 +1,108 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_RINGCACHE_H
+#define XMREG01_RINGCACHE_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "MappedFile.h"
+#include "RingSource.h"
+
+#include <string>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Index entry of a block of rings in the cache file
+     */
+    struct ring_cache_block
+    {
+        uint64_t first_height;
+        uint64_t last_height;
+        uint64_t input_no;
+        uint64_t offset;     // of the encoded rings in the data section
+        uint64_t size;       // of the encoded rings in bytes
+    };
+
+
+    /**
+     * Rings of inputs extracted from the blockchain once and
+     * saved into a sidecar file, so that later passes don't
+     * have to read lmdb and deserialize all transactions again.
+     *
+     * Rings are stored in blocks of rings from consecutive
+     * blockchain blocks, with a small index of the blocks,
+     * so that blocks can be decoded in parallel and those
+     * outside of the selected height range are skipped.
+     *
+     * Each ring is encoded as:
+     *
+     *   varint: height - height of previous ring in the block
+     *   32 bytes: key image
+     *   varint: amount
+     *   varint: ring size
+     *   varint * ring size: relative offsets, i.e., deltas
+     *                       of absolute offsets
+     *   varint * ring size: height - height of the ring member
+     *
+     * Tx hashes and input indices are not stored, so rings
+     * given by the cache don't have them set.
+     */
+    class RingCache : public RingSource
+    {
+        uint64_t m_from_height {0};
+        uint64_t m_to_height {0};
+
+        // height range given to passes using the cache
+        uint64_t m_scan_from {0};
+        uint64_t m_scan_to {0};
+
+        MappedFile m_file;
+
+        array_view<uint64_t>         m_amounts;
+        array_view<uint64_t>         m_amount_output_nos;
+        array_view<ring_cache_block> m_blocks;
+        array_view<unsigned char>    m_data;
+
+    public:
+
+        static bool
+        build(MicroCore& mcore,
+              uint64_t from_height,
+              uint64_t to_height,
+              const string& file_path,
+              size_t thread_no = 0);
+
+        bool
+        load(const string& file_path);
+
+        void
+        select(uint64_t from_height, uint64_t to_height);
+
+        uint64_t
+        from_height() const override;
+
+        uint64_t
+        to_height() const override;
+
+        size_t
+        chunk_no() const override;
+
+        uint64_t
+        output_no(uint64_t amount) const override;
+
+        bool
+        scan(const chunk_ring_processor& process_ring,
+             size_t thread_no = 0) const override;
+    };
+
+}
+
+#endif //XMREG01_RINGCACHE_H
@@ -0,0 +1,362 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "RingColumns.h"
+#include "MappedFile.h"
+#include "hex.h"
+
+#include <fstream>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        const char RING_COLUMNS_MAGIC[8] {'X', 'M', 'R', 'R', 'I', 'N', 'G', 'C'};
+
+        const uint64_t RING_COLUMNS_VERSION {1};
+
+        struct ring_columns_header
+        {
+            char     magic[8];
+            uint64_t version;
+            uint64_t tx_no;
+            uint64_t input_no;
+            uint64_t member_no;
+        };
+
+
+        /**
+         * Set bit idx of the bit column, which
+         * has exactly idx bits so far
+         */
+        inline void
+        push_bit(vector<uint64_t>& bits, size_t idx, bool value)
+        {
+            if (idx % 64 == 0)
+            {
+                bits.push_back(0);
+            }
+
+            bits.back() |= uint64_t {value} << (idx % 64);
+        }
+
+        inline bool
+        get_bit(const vector<uint64_t>& bits, size_t idx)
+        {
+            return (bits[idx / 64] >> (idx % 64)) & 1;
+        }
+
+        inline size_t
+        count_bits(const vector<uint64_t>& bits)
+        {
+            size_t count {0};
+
+            for (uint64_t word: bits)
+            {
+                count += __builtin_popcountll(word);
+            }
+
+            return count;
+        }
+
+
+        /**
+         * Write pod as a quoted hex string, without
+         * the angle brackets of its operator<<
+         */
+        template <typename POD>
+        void
+        write_json_hex(fmt::MemoryWriter& out, const POD& pod)
+        {
+            array<char, 2 * sizeof(POD) + 2> buffer;
+
+            buffer.front() = '"';
+            hex_encode(&pod, sizeof(POD), &buffer[1]);
+            buffer.back()  = '"';
+
+            out << fmt::StringRef(buffer.data(), buffer.size());
+        }
+    }
+
+
+    /**
+     * Add ring members of all non-coinbase inputs
+     * of the analyzed tx to the columns
+     */
+    void
+    RingColumns::append(const tx_analysis& result)
+    {
+        m_tx_hashes.push_back(result.hdr.tx_hash);
+        m_tx_heights.push_back(result.hdr.blk_height);
+
+        for (const input_details& in_details: result.inputs)
+        {
+            if (in_details.is_coinbase)
+            {
+                continue;
+            }
+
+            m_key_images.push_back(in_details.k_image);
+            m_input_amounts.push_back(in_details.amount);
+            m_input_indices.push_back(static_cast<uint32_t>(in_details.in_i));
+
+            for (const mixin_details& mixin: in_details.mixins)
+            {
+                size_t member_idx = m_block_heights.size();
+
+                m_block_heights.push_back(mixin.block_height);
+                m_timestamps.push_back(mixin.block_found ? mixin.blk_timestamp : 0);
+                m_global_indices.push_back(mixin.global_index);
+                m_output_indices.push_back(static_cast<uint32_t>(mixin.output_index));
+                m_out_pubkeys.push_back(mixin.out_pubkey);
+                m_out_tx_hashes.push_back(mixin.tx_hash);
+
+                push_bit(m_ours_bits, member_idx, mixin.is_ours);
+                push_bit(m_resolved_bits, member_idx, mixin.error.empty());
+            }
+
+            m_ring_ends.push_back(m_block_heights.size());
+        }
+
+        m_input_ends.push_back(m_key_images.size());
+    }
+
+
+    /**
+     * Remove all rows, keeping capacity of the columns,
+     * e.g., to stream results tx by tx
+     */
+    void
+    RingColumns::clear()
+    {
+        m_tx_hashes.clear();
+        m_tx_heights.clear();
+        m_input_ends.assign(1, 0);
+
+        m_key_images.clear();
+        m_input_amounts.clear();
+        m_input_indices.clear();
+        m_ring_ends.assign(1, 0);
+
+        m_block_heights.clear();
+        m_timestamps.clear();
+        m_global_indices.clear();
+        m_output_indices.clear();
+        m_out_pubkeys.clear();
+        m_out_tx_hashes.clear();
+        m_ours_bits.clear();
+        m_resolved_bits.clear();
+    }
+
+
+    void
+    RingColumns::reserve(size_t member_no)
+    {
+        m_block_heights.reserve(member_no);
+        m_timestamps.reserve(member_no);
+        m_global_indices.reserve(member_no);
+        m_output_indices.reserve(member_no);
+        m_out_pubkeys.reserve(member_no);
+        m_out_tx_hashes.reserve(member_no);
+        m_ours_bits.reserve(member_no / 64 + 1);
+        m_resolved_bits.reserve(member_no / 64 + 1);
+    }
+
+
+    size_t
+    RingColumns::tx_no() const
+    {
+        return m_tx_hashes.size();
+    }
+
+    size_t
+    RingColumns::input_no() const
+    {
+        return m_key_images.size();
+    }
+
+    size_t
+    RingColumns::member_no() const
+    {
+        return m_block_heights.size();
+    }
+
+    bool
+    RingColumns::is_ours(size_t member_idx) const
+    {
+        return get_bit(m_ours_bits, member_idx);
+    }
+
+    bool
+    RingColumns::is_resolved(size_t member_idx) const
+    {
+        return get_bit(m_resolved_bits, member_idx);
+    }
+
+
+    /**
+     * Count ours and unresolved members, and find height
+     * range and mean age of members with known timestamps.
+     *
+     * Each loop reads one or two columns only, without
+     * branches, so the compiler can vectorize it.
+     */
+    ring_columns_stats
+    RingColumns::stats(uint64_t current_timestamp) const
+    {
+        ring_columns_stats result;
+
+        result.tx_no         = tx_no();
+        result.input_no      = input_no();
+        result.member_no     = member_no();
+        result.ours_no       = count_bits(m_ours_bits);
+        result.unresolved_no = member_no() - count_bits(m_resolved_bits);
+
+        const size_t    n          = member_no();
+        const uint64_t* timestamps = m_timestamps.data();
+        const uint64_t* heights    = m_block_heights.data();
+
+        uint64_t min_height {numeric_limits<uint64_t>::max()};
+        uint64_t max_height {0};
+        uint64_t age_sum {0};
+        uint64_t dated_no {0};
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t dated = timestamps[i] != 0;
+
+            min_height = min(min_height, dated ? heights[i] : numeric_limits<uint64_t>::max());
+            max_height = max(max_height, dated ? heights[i] : 0);
+
+            // members newer than current_timestamp count as age 0
+            uint64_t age = current_timestamp > timestamps[i]
+                           ? current_timestamp - timestamps[i] : 0;
+
+            age_sum  += dated ? age : 0;
+            dated_no += dated;
+        }
+
+        if (dated_no > 0)
+        {
+            result.min_block_height = min_height;
+            result.max_block_height = max_height;
+            result.mean_age_seconds = static_cast<double>(age_sum) / dated_no;
+        }
+
+        return result;
+    }
+
+
+    /**
+     * Save all columns into a file: header, then the
+     * per tx, per input and per member arrays, in the order
+     * they are declared, each padded to 8 bytes as in
+     * other index files. Bit columns take member_no / 64
+     * words, rounded up.
+     */
+    bool
+    RingColumns::save(const string& file_path) const
+    {
+        ofstream out {file_path, ios::binary | ios::trunc};
+
+        if (!out)
+        {
+            cerr << "Cant write ring columns: " << file_path << endl;
+            return false;
+        }
+
+        ring_columns_header header;
+
+        memcpy(header.magic, RING_COLUMNS_MAGIC, sizeof(header.magic));
+
+        header.version   = RING_COLUMNS_VERSION;
+        header.tx_no     = tx_no();
+        header.input_no  = input_no();
+        header.member_no = member_no();
+
+        write_padded_array(out, &header, 1);
+
+        write_padded_array(out, m_tx_hashes.data(), m_tx_hashes.size());
+        write_padded_array(out, m_tx_heights.data(), m_tx_heights.size());
+        write_padded_array(out, m_input_ends.data(), m_input_ends.size());
+
+        write_padded_array(out, m_key_images.data(), m_key_images.size());
+        write_padded_array(out, m_input_amounts.data(), m_input_amounts.size());
+        write_padded_array(out, m_input_indices.data(), m_input_indices.size());
+        write_padded_array(out, m_ring_ends.data(), m_ring_ends.size());
+
+        write_padded_array(out, m_block_heights.data(), m_block_heights.size());
+        write_padded_array(out, m_timestamps.data(), m_timestamps.size());
+        write_padded_array(out, m_global_indices.data(), m_global_indices.size());
+        write_padded_array(out, m_output_indices.data(), m_output_indices.size());
+        write_padded_array(out, m_out_pubkeys.data(), m_out_pubkeys.size());
+        write_padded_array(out, m_out_tx_hashes.data(), m_out_tx_hashes.size());
+        write_padded_array(out, m_ours_bits.data(), m_ours_bits.size());
+        write_padded_array(out, m_resolved_bits.data(), m_resolved_bits.size());
+
+        if (!out.flush())
+        {
+            cerr << "Cant write ring columns: " << file_path << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Write one json object per line for each ring member
+     * of txs from from_tx onwards, e.g.,
+     *
+     * {"tx_hash":"..","blk_height":..,"in_i":..,"key_image":"..",
+     *  "amount":..,"mixin_no":..,"block_height":..,"timestamp":..,
+     *  "global_index":..,"output_index":..,"out_pubkey":"..",
+     *  "out_tx_hash":"..","is_ours":false,"resolved":true}
+     *
+     * mixin_no starts from 1, as in mixin_details and the
+     * printed output. timestamp is 0 if block of the member
+     * was not found.
+     */
+    void
+    RingColumns::write_ndjson(fmt::MemoryWriter& out, size_t from_tx) const
+    {
+        for (size_t tx_idx = from_tx; tx_idx < tx_no(); ++tx_idx)
+        {
+            for (size_t in_idx = m_input_ends[tx_idx];
+                 in_idx < m_input_ends[tx_idx + 1]; ++in_idx)
+            {
+                for (size_t m = m_ring_ends[in_idx]; m < m_ring_ends[in_idx + 1]; ++m)
+                {
+                    out << "{\"tx_hash\":";
+                    write_json_hex(out, m_tx_hashes[tx_idx]);
+
+                    out.write(",\"blk_height\":{:d},\"in_i\":{:d},\"key_image\":",
+                              m_tx_heights[tx_idx], m_input_indices[in_idx]);
+                    write_json_hex(out, m_key_images[in_idx]);
+
+                    out.write(",\"amount\":{:d},\"mixin_no\":{:d},\"block_height\":{:d},"
+                                      "\"timestamp\":{:d},\"global_index\":{:d},"
+                                      "\"output_index\":{:d},\"out_pubkey\":",
+                              m_input_amounts[in_idx], m - m_ring_ends[in_idx] + 1,
+                              m_block_heights[m], m_timestamps[m],
+                              m_global_indices[m], m_output_indices[m]);
+                    write_json_hex(out, m_out_pubkeys[m]);
+
+                    out << ",\"out_tx_hash\":";
+                    write_json_hex(out, m_out_tx_hashes[m]);
+
+                    out << ",\"is_ours\":" << (is_ours(m) ? "true" : "false")
+                        << ",\"resolved\":" << (is_resolved(m) ? "true" : "false")
+                        << "}\n";
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,118 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_RINGCOLUMNS_H
+#define XMREG01_RINGCOLUMNS_H
+
+#include "monero_headers.h"
+#include "RingAnalyzer.h"
+
+#include "../ext/format.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Totals over all ring members held in RingColumns
+     */
+    struct ring_columns_stats
+    {
+        size_t   tx_no {0};
+        size_t   input_no {0};
+        size_t   member_no {0};
+        size_t   ours_no {0};
+        size_t   unresolved_no {0};
+        uint64_t min_block_height {0};
+        uint64_t max_block_height {0};
+        double   mean_age_seconds {0};
+    };
+
+
+    /**
+     * Results of RingAnalyzer of many txs, kept column by
+     * column, instead of as tx_analysis objects, i.e., each
+     * field of all ring members is in its own contiguous array:
+     *
+     *   block_heights[m], timestamps[m], global_indices[m], ...
+     *
+     * Ring members of input i are [ring_ends[i], ring_ends[i + 1]),
+     * and inputs of tx t are [input_ends[t], input_ends[t + 1]).
+     * Is ours and resolved flags are bits in 64-bit words.
+     * Output keys and tx hashes of members are contiguous
+     * 32-byte arrays.
+     *
+     * Loops over a single field, e.g., ages of all members,
+     * touch only that field and can be vectorized, and
+     * the columns can be written out as they are.
+     * Coinbase inputs have no rings, so they are skipped.
+     */
+    class RingColumns
+    {
+        // per tx
+        vector<crypto::hash> m_tx_hashes;
+        vector<uint64_t>     m_tx_heights;
+        vector<uint64_t>     m_input_ends {0};
+
+        // per input
+        vector<key_image>    m_key_images;
+        vector<uint64_t>     m_input_amounts;
+        vector<uint32_t>     m_input_indices;
+        vector<uint64_t>     m_ring_ends {0};
+
+        // per ring member
+        vector<uint64_t>     m_block_heights;
+        vector<uint64_t>     m_timestamps;
+        vector<uint64_t>     m_global_indices;
+        vector<uint32_t>     m_output_indices;
+        vector<public_key>   m_out_pubkeys;
+        vector<crypto::hash> m_out_tx_hashes;
+        vector<uint64_t>     m_ours_bits;
+        vector<uint64_t>     m_resolved_bits;
+
+    public:
+
+        void
+        append(const tx_analysis& result);
+
+        void
+        clear();
+
+        void
+        reserve(size_t member_no);
+
+        size_t
+        tx_no() const;
+
+        size_t
+        input_no() const;
+
+        size_t
+        member_no() const;
+
+        bool
+        is_ours(size_t member_idx) const;
+
+        bool
+        is_resolved(size_t member_idx) const;
+
+        ring_columns_stats
+        stats(uint64_t current_timestamp) const;
+
+        bool
+        save(const string& file_path) const;
+
+        void
+        write_ndjson(fmt::MemoryWriter& out, size_t from_tx = 0) const;
+    };
+
+}
+
+#endif //XMREG01_RINGCOLUMNS_H
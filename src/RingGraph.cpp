@@ -0,0 +1,507 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "RingGraph.h"
+
+#include <map>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+
+namespace xmreg
+{
+
+    const uint32_t RingGraph::NO_ID;
+
+
+    namespace
+    {
+        const char RING_GRAPH_MAGIC[8] {'X', 'M', 'R', 'R', 'I', 'N', 'G', 'G'};
+
+        const uint64_t RING_GRAPH_VERSION {1};
+
+        struct ring_graph_header
+        {
+            char     magic[8];
+            uint64_t version;
+            uint64_t from_height;
+            uint64_t to_height;
+            uint64_t amount_no;
+            uint64_t input_no;
+            uint64_t edge_no;
+        };
+
+        // rings read by a single chunk of blocks
+        struct chunk_rings
+        {
+            vector<uint64_t>  amounts;
+            vector<uint32_t>  heights;
+            vector<key_image> key_images;
+            vector<uint32_t>  ring_sizes;
+            vector<uint64_t>  global_indices;
+        };
+    }
+
+
+    /**
+     * Read rings of all inputs given by the source
+     * and build the graph.
+     *
+     * Rings are read in parallel, in chunks, and each chunk
+     * collects its rings separately. The chunks are then merged
+     * in height order, once the amounts and the number of
+     * outputs of each amount are known.
+     */
+    bool
+    RingGraph::build(const RingSource& source, size_t thread_no)
+    {
+        vector<chunk_rings> chunks(source.chunk_no());
+
+        bool completed = source.scan([&](size_t chunk_idx, const input_ring& ring)
+        {
+            chunk_rings& chunk = chunks[chunk_idx];
+
+            chunk.amounts.push_back(ring.amount);
+            chunk.heights.push_back(static_cast<uint32_t>(ring.blk_height));
+            chunk.key_images.push_back(ring.k_image);
+            chunk.ring_sizes.push_back(static_cast<uint32_t>(ring.absolute_offsets.size()));
+
+            chunk.global_indices.insert(chunk.global_indices.end(),
+                                        ring.absolute_offsets.begin(),
+                                        ring.absolute_offsets.end());
+        }, thread_no);
+
+        if (!completed)
+        {
+            return false;
+        }
+
+        // find all amounts and the highest global index used for each
+        map<uint64_t, uint64_t> max_indices;
+
+        size_t input_no {0};
+        size_t edge_no {0};
+
+        for (const chunk_rings& chunk: chunks)
+        {
+            size_t edge_i {0};
+
+            for (size_t i = 0; i < chunk.amounts.size(); ++i)
+            {
+                size_t ring_size = chunk.ring_sizes[i];
+
+                if (ring_size > 0)
+                {
+                    // absolute offsets are sorted, so the last one is the highest
+                    uint64_t& max_index = max_indices[chunk.amounts[i]];
+                    max_index = max(max_index, chunk.global_indices[edge_i + ring_size - 1]);
+                }
+
+                edge_i += ring_size;
+            }
+
+            input_no += chunk.amounts.size();
+            edge_no  += edge_i;
+        }
+
+        m_amounts_vec.clear();
+        m_amount_offsets_vec.assign(1, 0);
+
+        for (const auto& amount_index: max_indices)
+        {
+            m_amounts_vec.push_back(amount_index.first);
+            m_amount_offsets_vec.push_back(m_amount_offsets_vec.back()
+                                           + amount_index.second + 1);
+        }
+
+        if (m_amount_offsets_vec.back() >= NO_ID || input_no >= NO_ID)
+        {
+            cerr << "Too many outputs or inputs for 32-bit ids: "
+                 << m_amount_offsets_vec.back() << " outputs, "
+                 << input_no << " inputs" << endl;
+            return false;
+        }
+
+        // merge the chunks in height order
+        m_row_offsets_vec.clear();
+        m_row_offsets_vec.reserve(input_no + 1);
+        m_row_offsets_vec.push_back(0);
+
+        m_input_heights_vec.clear();
+        m_input_heights_vec.reserve(input_no);
+
+        m_key_images_vec.clear();
+        m_key_images_vec.reserve(input_no);
+
+        m_members_vec.clear();
+        m_members_vec.reserve(edge_no);
+
+        for (chunk_rings& chunk: chunks)
+        {
+            size_t edge_i {0};
+
+            for (size_t i = 0; i < chunk.amounts.size(); ++i)
+            {
+                size_t amount_idx = lower_bound(m_amounts_vec.begin(),
+                                                m_amounts_vec.end(),
+                                                chunk.amounts[i])
+                                    - m_amounts_vec.begin();
+
+                uint64_t first_id = m_amount_offsets_vec[amount_idx];
+
+                for (size_t j = 0; j < chunk.ring_sizes[i]; ++j)
+                {
+                    m_members_vec.push_back(static_cast<uint32_t>(
+                            first_id + chunk.global_indices[edge_i + j]));
+                }
+
+                edge_i += chunk.ring_sizes[i];
+
+                m_row_offsets_vec.push_back(m_members_vec.size());
+            }
+
+            m_input_heights_vec.insert(m_input_heights_vec.end(),
+                                       chunk.heights.begin(), chunk.heights.end());
+
+            m_key_images_vec.insert(m_key_images_vec.end(),
+                                    chunk.key_images.begin(), chunk.key_images.end());
+
+            // free memory of merged chunk as we go
+            chunk = chunk_rings {};
+        }
+
+        m_from_height = source.from_height();
+        m_to_height   = source.to_height();
+
+        m_file.close();
+
+        set_views_to_vectors();
+
+        return true;
+    }
+
+
+    /**
+     * Save the graph into a binary file, which can
+     * be later memory mapped using load().
+     */
+    bool
+    RingGraph::save(const string& file_path) const
+    {
+        ofstream out {file_path, ios::binary | ios::trunc};
+
+        if (!out)
+        {
+            cerr << "Cant write ring graph: " << file_path << endl;
+            return false;
+        }
+
+        ring_graph_header header;
+
+        memcpy(header.magic, RING_GRAPH_MAGIC, sizeof(header.magic));
+
+        header.version     = RING_GRAPH_VERSION;
+        header.from_height = m_from_height;
+        header.to_height   = m_to_height;
+        header.amount_no   = m_amounts.size();
+        header.input_no    = input_no();
+        header.edge_no     = m_members.size();
+
+        write_padded_array(out, &header, 1);
+        write_padded_array(out, m_amounts.begin(), m_amounts.size());
+        write_padded_array(out, m_amount_offsets.begin(), m_amount_offsets.size());
+        write_padded_array(out, m_row_offsets.begin(), m_row_offsets.size());
+        write_padded_array(out, m_key_images.begin(), m_key_images.size());
+        write_padded_array(out, m_input_heights.begin(), m_input_heights.size());
+        write_padded_array(out, m_members.begin(), m_members.size());
+
+        if (!out.flush())
+        {
+            cerr << "Cant write ring graph: " << file_path << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Memory map the graph saved with save().
+     * Nothing is copied, so this takes no time.
+     */
+    bool
+    RingGraph::load(const string& file_path)
+    {
+        if (!m_file.open(file_path))
+        {
+            return false;
+        }
+
+        if (m_file.size() < sizeof(ring_graph_header))
+        {
+            cerr << "Ring graph file too short: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        ring_graph_header header;
+        memcpy(&header, m_file.data(), sizeof(header));
+
+        if (memcmp(header.magic, RING_GRAPH_MAGIC, sizeof(header.magic)) != 0
+            || header.version != RING_GRAPH_VERSION)
+        {
+            cerr << "Not a ring graph file: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        size_t offset = padded_size(sizeof(ring_graph_header));
+
+        if (!map_padded_array(m_file, offset, header.amount_no, m_amounts)
+            || !map_padded_array(m_file, offset, header.amount_no + 1, m_amount_offsets)
+            || !map_padded_array(m_file, offset, header.input_no + 1, m_row_offsets)
+            || !map_padded_array(m_file, offset, header.input_no, m_key_images)
+            || !map_padded_array(m_file, offset, header.input_no, m_input_heights)
+            || !map_padded_array(m_file, offset, header.edge_no, m_members))
+        {
+            cerr << "Ring graph file is truncated: " << file_path << endl;
+            m_file.close();
+            return false;
+        }
+
+        m_from_height = header.from_height;
+        m_to_height   = header.to_height;
+
+        // free memory of previously built graph
+        m_amounts_vec        = vector<uint64_t> {};
+        m_amount_offsets_vec = vector<uint64_t> {};
+        m_row_offsets_vec    = vector<uint64_t> {};
+        m_input_heights_vec  = vector<uint32_t> {};
+        m_key_images_vec     = vector<key_image> {};
+        m_members_vec        = vector<uint32_t> {};
+
+        m_out_offsets.clear();
+        m_out_inputs.clear();
+
+        return true;
+    }
+
+
+    /**
+     * Build reverse graph, i.e., for each output
+     * the list of inputs which rings reference it.
+     * This is CSR as well, built with counting sort.
+     */
+    void
+    RingGraph::build_reverse()
+    {
+        m_out_offsets.assign(output_no() + 1, 0);
+
+        for (uint32_t output_id: m_members)
+        {
+            ++m_out_offsets[output_id + 1];
+        }
+
+        for (size_t i = 1; i < m_out_offsets.size(); ++i)
+        {
+            m_out_offsets[i] += m_out_offsets[i - 1];
+        }
+
+        m_out_inputs.resize(m_members.size());
+
+        vector<uint64_t> next_slot(m_out_offsets.begin(), m_out_offsets.end() - 1);
+
+        for (size_t input_id = 0; input_id < input_no(); ++input_id)
+        {
+            for (uint32_t output_id: ring(input_id))
+            {
+                m_out_inputs[next_slot[output_id]++] = static_cast<uint32_t>(input_id);
+            }
+        }
+    }
+
+
+    uint64_t
+    RingGraph::from_height() const
+    {
+        return m_from_height;
+    }
+
+    uint64_t
+    RingGraph::to_height() const
+    {
+        return m_to_height;
+    }
+
+    size_t
+    RingGraph::input_no() const
+    {
+        return m_row_offsets.empty() ? 0 : m_row_offsets.size() - 1;
+    }
+
+    size_t
+    RingGraph::output_no() const
+    {
+        return m_amount_offsets.empty() ? 0 : m_amount_offsets[m_amount_offsets.size() - 1];
+    }
+
+    size_t
+    RingGraph::edge_no() const
+    {
+        return m_members.size();
+    }
+
+
+    /**
+     * Get id of output with the given amount and global index.
+     *
+     * returns NO_ID if no ring in the graph references
+     * outputs of that amount with such a high index
+     */
+    uint32_t
+    RingGraph::output_id(uint64_t amount, uint64_t global_index) const
+    {
+        const uint64_t* it = lower_bound(m_amounts.begin(), m_amounts.end(), amount);
+
+        if (it == m_amounts.end() || *it != amount)
+        {
+            return NO_ID;
+        }
+
+        size_t amount_idx = it - m_amounts.begin();
+
+        uint64_t first_id = m_amount_offsets[amount_idx];
+        uint64_t next_id  = m_amount_offsets[amount_idx + 1];
+
+        if (global_index >= next_id - first_id)
+        {
+            return NO_ID;
+        }
+
+        return static_cast<uint32_t>(first_id + global_index);
+    }
+
+
+    /**
+     * Get amount and global index of the given output id
+     */
+    bool
+    RingGraph::output_of_id(uint32_t output_id,
+                            uint64_t& amount,
+                            uint64_t& global_index) const
+    {
+        if (output_id >= output_no())
+        {
+            return false;
+        }
+
+        // first amount which range starts after the output
+        const uint64_t* it = upper_bound(m_amount_offsets.begin(),
+                                         m_amount_offsets.end(),
+                                         uint64_t {output_id});
+
+        size_t amount_idx = (it - m_amount_offsets.begin()) - 1;
+
+        amount       = m_amounts[amount_idx];
+        global_index = output_id - m_amount_offsets[amount_idx];
+
+        return true;
+    }
+
+
+    /**
+     * Find input with the given key image. Inputs are sorted by
+     * height, so only inputs of the given block are checked.
+     *
+     * returns NO_ID if the input is not in the graph
+     */
+    uint32_t
+    RingGraph::input_id(const key_image& k_image, uint64_t blk_height) const
+    {
+        if (blk_height >= NO_ID)
+        {
+            return NO_ID;
+        }
+
+        uint32_t height32 = static_cast<uint32_t>(blk_height);
+
+        auto range = equal_range(m_input_heights.begin(),
+                                 m_input_heights.end(),
+                                 height32);
+
+        for (const uint32_t* it = range.first; it != range.second; ++it)
+        {
+            size_t input_id = it - m_input_heights.begin();
+
+            if (m_key_images[input_id] == k_image)
+            {
+                return static_cast<uint32_t>(input_id);
+            }
+        }
+
+        return NO_ID;
+    }
+
+
+    /**
+     * Output ids referenced by the ring of the given input
+     */
+    array_view<uint32_t>
+    RingGraph::ring(size_t input_id) const
+    {
+        uint64_t begin = m_row_offsets[input_id];
+        uint64_t end   = m_row_offsets[input_id + 1];
+
+        return array_view<uint32_t> {m_members.begin() + begin, end - begin};
+    }
+
+
+    /**
+     * Input ids which rings reference the given output.
+     * Requires build_reverse() to be called first.
+     */
+    array_view<uint32_t>
+    RingGraph::referencing_inputs(uint32_t output_id) const
+    {
+        if (output_id + size_t {1} >= m_out_offsets.size())
+        {
+            return array_view<uint32_t> {};
+        }
+
+        uint64_t begin = m_out_offsets[output_id];
+        uint64_t end   = m_out_offsets[output_id + 1];
+
+        return array_view<uint32_t> {m_out_inputs.data() + begin, end - begin};
+    }
+
+
+    uint32_t
+    RingGraph::input_height(size_t input_id) const
+    {
+        return m_input_heights[input_id];
+    }
+
+    const key_image&
+    RingGraph::input_key_image(size_t input_id) const
+    {
+        return m_key_images[input_id];
+    }
+
+
+    void
+    RingGraph::set_views_to_vectors()
+    {
+        m_amounts        = {m_amounts_vec.data(), m_amounts_vec.size()};
+        m_amount_offsets = {m_amount_offsets_vec.data(), m_amount_offsets_vec.size()};
+        m_row_offsets    = {m_row_offsets_vec.data(), m_row_offsets_vec.size()};
+        m_input_heights  = {m_input_heights_vec.data(), m_input_heights_vec.size()};
+        m_key_images     = {m_key_images_vec.data(), m_key_images_vec.size()};
+        m_members        = {m_members_vec.data(), m_members_vec.size()};
+
+        m_out_offsets.clear();
+        m_out_inputs.clear();
+    }
+
+}
@@ -0,0 +1,141 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_RINGGRAPH_H
+#define XMREG01_RINGGRAPH_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "MappedFile.h"
+#include "RingSource.h"
+
+#include <string>
+#include <vector>
+#include <limits>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Graph of spending inputs and outputs referenced
+     * by their rings, for a given height range.
+     *
+     * Outputs are identified by (amount, global index) pairs,
+     * which are mapped to dense 32-bit output ids: amounts are
+     * sorted, and each amount gets a contiguous range of ids,
+     * one for each global index up to the highest one referenced.
+     *
+     * Inputs are numbered in blockchain order. Rings are kept
+     * in the compressed sparse row (CSR) form, i.e., the members
+     * of input i are output ids
+     *
+     *   members[row_offsets[i]] ... members[row_offsets[i + 1] - 1]
+     *
+     * There are no per input or per edge objects, so the whole
+     * pre-RingCT blockchain takes a few GB. The graph can be saved
+     * into a file, and later memory mapped, so that analyses
+     * can start without rebuilding it.
+     *
+     * The reverse graph, i.e., inputs referencing each output,
+     * is built on demand with build_reverse().
+     */
+    class RingGraph
+    {
+    public:
+
+        static const uint32_t NO_ID = numeric_limits<uint32_t>::max();
+
+    private:
+
+        uint64_t m_from_height {0};
+        uint64_t m_to_height {0};
+
+        // storage for the arrays, when built in memory
+        vector<uint64_t>  m_amounts_vec;
+        vector<uint64_t>  m_amount_offsets_vec;
+        vector<uint64_t>  m_row_offsets_vec;
+        vector<uint32_t>  m_input_heights_vec;
+        vector<key_image> m_key_images_vec;
+        vector<uint32_t>  m_members_vec;
+
+        // storage for the arrays, when loaded from a file
+        MappedFile m_file;
+
+        // the arrays themselves, pointing into one of the above
+        array_view<uint64_t>  m_amounts;
+        array_view<uint64_t>  m_amount_offsets;
+        array_view<uint64_t>  m_row_offsets;
+        array_view<uint32_t>  m_input_heights;
+        array_view<key_image> m_key_images;
+        array_view<uint32_t>  m_members;
+
+        // reverse graph, i.e., inputs of each output
+        vector<uint64_t> m_out_offsets;
+        vector<uint32_t> m_out_inputs;
+
+    public:
+
+        bool
+        build(const RingSource& source, size_t thread_no = 0);
+
+        bool
+        save(const string& file_path) const;
+
+        bool
+        load(const string& file_path);
+
+        void
+        build_reverse();
+
+        uint64_t
+        from_height() const;
+
+        uint64_t
+        to_height() const;
+
+        size_t
+        input_no() const;
+
+        size_t
+        output_no() const;
+
+        size_t
+        edge_no() const;
+
+        uint32_t
+        output_id(uint64_t amount, uint64_t global_index) const;
+
+        bool
+        output_of_id(uint32_t output_id,
+                     uint64_t& amount,
+                     uint64_t& global_index) const;
+
+        uint32_t
+        input_id(const key_image& k_image, uint64_t blk_height) const;
+
+        array_view<uint32_t>
+        ring(size_t input_id) const;
+
+        array_view<uint32_t>
+        referencing_inputs(uint32_t output_id) const;
+
+        uint32_t
+        input_height(size_t input_id) const;
+
+        const key_image&
+        input_key_image(size_t input_id) const;
+
+    private:
+
+        void
+        set_views_to_vectors();
+    };
+
+}
+
+#endif //XMREG01_RINGGRAPH_H
@@ -0,0 +1,287 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "RingPrinter.h"
+#include "tools.h"
+
+#include <cstdio>
+
+
+namespace xmreg
+{
+
+    using fmt::Color;
+
+
+    RingPrinter::RingPrinter(uint64_t current_blk_timestamp,
+                             time_t server_timestamp)
+            : m_current_blk_timestamp {current_blk_timestamp},
+              m_server_timestamp {server_timestamp}
+    {}
+
+
+    /**
+     * Show our keys with each tx, and
+     * whether its mixins are ours
+     */
+    void
+    RingPrinter::show_keys(const secret_key& private_view_key,
+                           const account_public_address& address,
+                           bool testnet)
+    {
+        m_private_view_key = &private_view_key;
+        m_address          = &address;
+        m_testnet          = testnet;
+    }
+
+    void
+    RingPrinter::show_owners(const AccountSet& accounts)
+    {
+        m_accounts = &accounts;
+    }
+
+    /**
+     * Mark mixins provably spent elsewhere,
+     * or provably real, using the cascade results
+     */
+    void
+    RingPrinter::show_cascade(const RingGraph& ring_graph,
+                              const ZeroMixinCascade& cascade)
+    {
+        m_ring_graph = &ring_graph;
+        m_cascade    = &cascade;
+    }
+
+    void
+    RingPrinter::show_decoy_counts(const DecoyCounter& decoy_counter)
+    {
+        m_decoy_counter = &decoy_counter;
+    }
+
+    /**
+     * Give output to the writer, instead of
+     * writing it to the stdout directly
+     */
+    void
+    RingPrinter::write_to(OutputWriter& writer)
+    {
+        m_writer = &writer;
+    }
+
+    /**
+     * Whether to color parts of output with terminal
+     * escape codes. Without them, output is smaller,
+     * and is cleaner when saved into a file.
+     */
+    void
+    RingPrinter::use_colors(bool colors)
+    {
+        m_colors = colors;
+    }
+
+
+    void
+    RingPrinter::print_header(const tx_header_details& hdr)
+    {
+        if (hdr.has_encrypted_payment_id)
+        {
+            m_out.write("\nPayment id (encrypted): {:s}\n", hdr.encrypted_payment_id);
+        }
+        else if (hdr.has_payment_id)
+        {
+            m_out.write("\nPayment id: {:s}\n", hdr.payment_id);
+        }
+        else
+        {
+            m_out.write("\nPayment id: not present\n");
+        }
+
+        m_out.write("\ntx hash          : {}, block height {}\n\n",
+                    hdr.tx_hash, hdr.blk_height);
+
+        if (m_private_view_key)
+        {
+            // lets check our keys
+            m_out.write("private view key : {}\n", *m_private_view_key);
+            m_out.write("address          : {}\n\n\n", print_address(*m_address, m_testnet));
+        }
+
+        m_tx_blk_height = hdr.blk_height;
+
+        m_mixin_timescales.clear();
+        m_mixin_timescale_ends.clear();
+
+        flush_output();
+    }
+
+
+    void
+    RingPrinter::print_input(const input_details& in_details)
+    {
+        if (in_details.is_coinbase)
+        {
+            m_out.write(" - coinbase tx: no inputs here.\n");
+            flush_output();
+            return;
+        }
+
+        m_out.write("Input's key image: {}, xmr: {:0.8f}\n",
+                    in_details.k_image,
+                    get_xmr(in_details.amount));
+
+        uint32_t input_id = m_cascade
+                            ? m_ring_graph->input_id(in_details.k_image, m_tx_blk_height)
+                            : RingGraph::NO_ID;
+
+        for (const mixin_details& mixin: in_details.mixins)
+        {
+            if (mixin.block_found)
+            {
+                // calculate time difference bewteen mixing block and current blockchain height
+                array<size_t, 5> time_diff;
+                time_diff = timestamp_difference(m_current_blk_timestamp,
+                                                 mixin.blk_timestamp);
+
+                m_out.write("\n - mixin no: {}, block height: {}, timestamp: {}, "
+                                    "time_diff: {} y, {} d, {} h, {} m, {} s",
+                            mixin.mixin_no, mixin.block_height,
+                            timestamp_to_str(mixin.blk_timestamp),
+                            time_diff[0], time_diff[1], time_diff[2], time_diff[3], time_diff[4]);
+            }
+
+            if (!mixin.error.empty())
+            {
+                m_out.write("{}", mixin.error);
+                continue;
+            }
+
+            if (m_private_view_key)
+            {
+                Color c  = mixin.is_ours ? Color::GREEN : Color::RED;
+
+                m_out.write(", ours: "); write_colored(c, "{}", mixin.is_ours);
+            }
+
+            if (m_accounts)
+            {
+                m_out.write(", owned by: ");
+
+                if (mixin.owners.empty())
+                {
+                    write_colored(Color::RED, "none");
+                }
+
+                for (size_t acc_i: mixin.owners)
+                {
+                    write_colored(Color::GREEN, "{} ", (*m_accounts)[acc_i].address_str);
+                }
+            }
+
+            if (m_decoy_counter)
+            {
+                m_out.write(", times used as ring member: {:d}",
+                            m_decoy_counter->times_used(in_details.amount, mixin.global_index));
+            }
+
+            if (input_id != RingGraph::NO_ID)
+            {
+                uint32_t output_id = m_ring_graph->output_id(in_details.amount,
+                                                             mixin.global_index);
+
+                if (m_cascade->is_spent_elsewhere(output_id, input_id))
+                {
+                    m_out.write(", "); write_colored(Color::RED, "provably spent elsewhere");
+                }
+                else if (m_cascade->spending_input(output_id) == input_id)
+                {
+                    m_out.write(", "); write_colored(Color::GREEN, "provably real");
+                }
+            }
+
+            m_out.write("\n"
+                        "  - output's pubkey: {}\n", mixin.out_pubkey);
+
+            m_out.write("  - in tx with hash: {}\n", mixin.tx_hash);
+
+            m_out.write("  - this tx pub key: {}\n", mixin.tx_pub_key);
+
+            m_out.write("  - out_i: {:03d}, g_idx: {:d}, xmr: {:0.8f}\n",
+                        mixin.output_index, mixin.global_index, get_xmr(mixin.amount));
+        }
+
+        // get mixins in time scale for visual representation,
+        // and save it after the previous ones for later to show
+        append_timestamps_time_scale(in_details.mixin_timestamps,
+                                     m_mixin_timescales,
+                                     m_server_timestamp);
+
+        m_mixin_timescale_ends.push_back(m_mixin_timescales.size());
+
+        m_out.write("\nRing signature for the above input, i.e.,: key image {}, xmr: {:0.8f}: \n\n",
+                    in_details.k_image, get_xmr(in_details.amount));
+
+        for (const crypto::signature &sig: in_details.signatures)
+        {
+            m_out.write(" - {}\n", print_sig(sig));
+        }
+
+        m_out << '\n';
+
+        flush_output();
+    }
+
+
+    void
+    RingPrinter::print_footer()
+    {
+        m_out.write("\nMixin timescales for this transaction: \n\n");
+
+        size_t begin {0};
+
+        for (size_t end: m_mixin_timescale_ends)
+        {
+            m_out << "Genesis <"
+                  << fmt::StringRef(m_mixin_timescales.data() + begin, end - begin)
+                  << "> " << timestamp_to_str(m_server_timestamp, "%F") << '\n';
+
+            begin = end;
+        }
+
+        flush_output();
+    }
+
+
+    void
+    RingPrinter::print_tx(const tx_analysis& result)
+    {
+        print_header(result.hdr);
+
+        for (const input_details& in_details: result.inputs)
+        {
+            print_input(in_details);
+        }
+
+        print_footer();
+    }
+
+
+    /**
+     * Pass formatted output to the writer, or to the stdout
+     */
+    void
+    RingPrinter::flush_output()
+    {
+        if (m_writer)
+        {
+            m_writer->write(m_out.data(), m_out.size());
+        }
+        else
+        {
+            fwrite(m_out.data(), 1, m_out.size(), stdout);
+        }
+
+        m_out.clear();
+    }
+
+}
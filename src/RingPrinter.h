@@ -0,0 +1,140 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_RINGPRINTER_H
+#define XMREG01_RINGPRINTER_H
+
+#include "monero_headers.h"
+#include "RingAnalyzer.h"
+#include "RingGraph.h"
+#include "ZeroMixinCascade.h"
+#include "DecoyCounter.h"
+#include "OutputWriter.h"
+
+#include "../ext/format.h"
+
+#include <string>
+#include <vector>
+#include <ctime>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Prints results of RingAnalyzer to the stdout,
+     * i.e., payment id, mixins of each input with their
+     * timestamps, and ring signatures, followed by
+     * timescales of all mixins of the transaction.
+     *
+     * Optional columns, e.g., owners of mixins or
+     * decoy counts, are shown once their data is given.
+     *
+     * Output of each call is formatted into a buffer and
+     * passed at once to the OutputWriter, if one is given,
+     * so that analysis does not wait on the terminal.
+     */
+    class RingPrinter
+    {
+        // time of the top block, to show age of mixins
+        uint64_t m_current_blk_timestamp;
+
+        // end of the timescales
+        time_t m_server_timestamp;
+
+        const secret_key*             m_private_view_key {nullptr};
+        const account_public_address* m_address {nullptr};
+        bool                          m_testnet {false};
+
+        const AccountSet*       m_accounts {nullptr};
+        const RingGraph*        m_ring_graph {nullptr};
+        const ZeroMixinCascade* m_cascade {nullptr};
+        const DecoyCounter*     m_decoy_counter {nullptr};
+
+        // height of the tx being printed
+        uint64_t m_tx_blk_height {0};
+
+        // timescales of inputs of the tx being printed,
+        // one after another, and where each of them ends.
+        // Cleared at each tx header, keeping their memory.
+        string         m_mixin_timescales;
+        vector<size_t> m_mixin_timescale_ends;
+
+        // formatted output not yet passed on
+        fmt::MemoryWriter m_out;
+
+        OutputWriter* m_writer {nullptr};
+
+        bool m_colors {true};
+
+    public:
+
+        RingPrinter(uint64_t current_blk_timestamp, time_t server_timestamp);
+
+        void
+        show_keys(const secret_key& private_view_key,
+                  const account_public_address& address,
+                  bool testnet);
+
+        void
+        show_owners(const AccountSet& accounts);
+
+        void
+        show_cascade(const RingGraph& ring_graph, const ZeroMixinCascade& cascade);
+
+        void
+        show_decoy_counts(const DecoyCounter& decoy_counter);
+
+        void
+        write_to(OutputWriter& writer);
+
+        void
+        use_colors(bool colors);
+
+        void
+        print_header(const tx_header_details& hdr);
+
+        void
+        print_input(const input_details& in_details);
+
+        void
+        print_footer();
+
+        void
+        print_tx(const tx_analysis& result);
+
+    private:
+
+        /**
+         * Same as fmt::print_colored, but into m_out,
+         * and without escape codes if colors are off
+         */
+        template <typename... Args>
+        void
+        write_colored(fmt::Color c, fmt::CStringRef format_str, const Args&... args)
+        {
+            if (m_colors)
+            {
+                const char escape[] = {'\x1b', '[', '3', static_cast<char>('0' + c), 'm'};
+                m_out << fmt::StringRef(escape, sizeof(escape));
+            }
+
+            m_out.write(format_str, args...);
+
+            if (m_colors)
+            {
+                m_out << "\x1b[0m";
+            }
+        }
+
+        void
+        flush_output();
+    };
+
+}
+
+#endif //XMREG01_RINGPRINTER_H
@@ -0,0 +1,113 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "RingSource.h"
+
+#include <atomic>
+
+
+namespace xmreg
+{
+
+    ChainRingSource::ChainRingSource(MicroCore& mcore,
+                                     uint64_t from_height,
+                                     uint64_t to_height,
+                                     uint64_t chunk_size,
+                                     bool resolve_heights)
+            : m_mcore {mcore},
+              m_from_height {from_height},
+              m_to_height {to_height},
+              m_chunk_size {chunk_size},
+              m_resolve_heights {resolve_heights}
+    {}
+
+
+    uint64_t
+    ChainRingSource::from_height() const
+    {
+        return m_from_height;
+    }
+
+    uint64_t
+    ChainRingSource::to_height() const
+    {
+        return m_to_height;
+    }
+
+    size_t
+    ChainRingSource::chunk_no() const
+    {
+        return get_chunk_no(m_from_height, m_to_height, m_chunk_size);
+    }
+
+    uint64_t
+    ChainRingSource::output_no(uint64_t amount) const
+    {
+        return m_mcore.get_core().get_db().get_num_outputs(amount);
+    }
+
+
+    /**
+     * Read rings using parallel_scan_rings. If resolve_heights
+     * was set, heights of blocks with the ring members are
+     * looked up as well, which takes an extra lmdb read
+     * per ring member.
+     *
+     * returns false if the scan was stopped, or some
+     * rings or their members could not be read
+     */
+    bool
+    ChainRingSource::scan(const chunk_ring_processor& process_ring,
+                          size_t thread_no) const
+    {
+        if (!m_resolve_heights)
+        {
+            return parallel_scan_rings(m_mcore, m_from_height, m_to_height,
+                                       m_chunk_size, process_ring, thread_no);
+        }
+
+        BlockchainDB& db = m_mcore.get_core().get_db();
+
+        // set at the first ring which could not be resolved,
+        // after which the remaining rings are just skipped
+        atomic<bool> failed {false};
+
+        bool completed = parallel_scan_rings(m_mcore, m_from_height, m_to_height,
+                                             m_chunk_size,
+                                             [&](size_t chunk_idx, const input_ring& ring)
+        {
+            if (failed)
+            {
+                return;
+            }
+
+            input_ring resolved_ring = ring;
+
+            vector<output_data_t> outputs;
+
+            try
+            {
+                db.get_output_key(ring.amount, ring.absolute_offsets, outputs);
+            }
+            catch (const std::exception& e)
+            {
+                cerr << "Cant get outputs of ring with key image "
+                     << ring.k_image << ": " << e.what() << endl;
+
+                failed = true;
+                return;
+            }
+
+            for (const output_data_t& output: outputs)
+            {
+                resolved_ring.member_heights.push_back(output.height);
+            }
+
+            process_ring(chunk_idx, resolved_ring);
+        }, thread_no);
+
+        return completed && !failed;
+    }
+
+}
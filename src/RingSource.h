@@ -0,0 +1,95 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_RINGSOURCE_H
+#define XMREG01_RINGSOURCE_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "chain_scan.h"
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Where chain-wide passes, e.g., RingGraph or DecoyCounter,
+     * get rings of inputs from: the blockchain itself, or
+     * a RingCache extracted from it earlier.
+     *
+     * Rings are given in chunks, in parallel, as in
+     * parallel_scan_rings. Rings within a chunk are in height
+     * order, and chunk_idx is below chunk_no().
+     */
+    class RingSource
+    {
+    public:
+
+        virtual uint64_t
+        from_height() const = 0;
+
+        virtual uint64_t
+        to_height() const = 0;
+
+        virtual size_t
+        chunk_no() const = 0;
+
+        // number of outputs of the given amount, at least
+        // as many as referenced by the rings
+        virtual uint64_t
+        output_no(uint64_t amount) const = 0;
+
+        virtual bool
+        scan(const chunk_ring_processor& process_ring,
+             size_t thread_no = 0) const = 0;
+
+        virtual ~RingSource() = default;
+    };
+
+
+    /**
+     * Rings read from the blockchain
+     */
+    class ChainRingSource : public RingSource
+    {
+        MicroCore& m_mcore;
+
+        uint64_t m_from_height;
+        uint64_t m_to_height;
+        uint64_t m_chunk_size;
+
+        // should heights of the ring members be looked up
+        bool m_resolve_heights;
+
+    public:
+
+        ChainRingSource(MicroCore& mcore,
+                        uint64_t from_height,
+                        uint64_t to_height,
+                        uint64_t chunk_size = 10000,
+                        bool resolve_heights = false);
+
+        uint64_t
+        from_height() const override;
+
+        uint64_t
+        to_height() const override;
+
+        size_t
+        chunk_no() const override;
+
+        uint64_t
+        output_no(uint64_t amount) const override;
+
+        bool
+        scan(const chunk_ring_processor& process_ring,
+             size_t thread_no = 0) const override;
+    };
+
+}
+
+#endif //XMREG01_RINGSOURCE_H
@@ -0,0 +1,304 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "ScanCheckpoint.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+
+
+namespace xmreg
+{
+
+    ScanCheckpoint::ScanCheckpoint(const string& file_path,
+                                   const string& scan_id)
+            : m_file_path {file_path}, m_scan_id {scan_id}
+    {}
+
+
+    /**
+     * Read checkpoint file, if it exists.
+     *
+     * Each line starts with a keyword:
+     *
+     *   scan <scan id>
+     *   height <last processed block height>
+     *   hash <hash of a recent block>        (oldest first)
+     *   rec <block height> <record data>
+     *
+     * returns false if there is no checkpoint to resume,
+     * e.g., the file is missing or is for a different scan
+     */
+    bool
+    ScanCheckpoint::load()
+    {
+        ifstream in {m_file_path};
+
+        if (!in)
+        {
+            return false;
+        }
+
+        string line;
+
+        string scan_id;
+        uint64_t last_height {0};
+        bool height_found {false};
+
+        deque<crypto::hash> recent_hashes;
+        vector<checkpoint_record> records;
+
+        while (getline(in, line))
+        {
+            istringstream line_ss {line};
+
+            string keyword;
+            line_ss >> keyword;
+
+            if (keyword == "scan")
+            {
+                line_ss >> ws;
+                getline(line_ss, scan_id);
+            }
+            else if (keyword == "height")
+            {
+                height_found = bool(line_ss >> last_height);
+            }
+            else if (keyword == "hash")
+            {
+                string hash_str;
+                crypto::hash blk_hash;
+
+                if (!(line_ss >> hash_str)
+                    || !epee::string_tools::hex_to_pod(hash_str, blk_hash))
+                {
+                    cerr << "Incorrect block hash in checkpoint: "
+                         << m_file_path << endl;
+                    return false;
+                }
+
+                recent_hashes.push_back(blk_hash);
+            }
+            else if (keyword == "rec")
+            {
+                checkpoint_record rec;
+
+                if (line_ss >> rec.blk_height)
+                {
+                    line_ss >> ws;
+                    getline(line_ss, rec.data);
+                    records.push_back(rec);
+                }
+            }
+        }
+
+        if (scan_id != m_scan_id)
+        {
+            cerr << "Checkpoint " << m_file_path
+                 << " is for a different scan, starting a new one." << endl;
+            return false;
+        }
+
+        if (!height_found || recent_hashes.empty())
+        {
+            return false;
+        }
+
+        m_has_progress  = true;
+        m_last_height   = last_height;
+        m_recent_hashes = recent_hashes;
+        m_records       = records;
+
+        return true;
+    }
+
+
+    /**
+     * Write checkpoint to a temporary file first and then rename it,
+     * so that an interruption during saving does not leave
+     * a broken checkpoint behind.
+     */
+    bool
+    ScanCheckpoint::save() const
+    {
+        string tmp_path = m_file_path + ".tmp";
+
+        {
+            ofstream out {tmp_path, ios::trunc};
+
+            if (!out)
+            {
+                cerr << "Cant write checkpoint: " << tmp_path << endl;
+                return false;
+            }
+
+            out << "scan " << m_scan_id << '\n';
+
+            if (m_has_progress)
+            {
+                out << "height " << m_last_height << '\n';
+
+                for (const crypto::hash& blk_hash: m_recent_hashes)
+                {
+                    out << "hash " << epee::string_tools::pod_to_hex(blk_hash) << '\n';
+                }
+            }
+
+            for (const checkpoint_record& rec: m_records)
+            {
+                out << "rec " << rec.blk_height << ' ' << rec.data << '\n';
+            }
+
+            if (!out.flush())
+            {
+                cerr << "Cant write checkpoint: " << tmp_path << endl;
+                return false;
+            }
+        }
+
+        if (std::rename(tmp_path.c_str(), m_file_path.c_str()) != 0)
+        {
+            cerr << "Cant rename " << tmp_path
+                 << " to " << m_file_path << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Find the height from which the scan should continue.
+     *
+     * Recent block hashes are checked against the blockchain,
+     * starting from the newest one. If the newest one does
+     * not match, there was a reorganization and we go back
+     * to the last block that matches. If none match, the
+     * reorganization is deeper than we can track, and
+     * the scan has to start from the beginning.
+     *
+     * returns false if there is no progress to resume from
+     */
+    bool
+    ScanCheckpoint::resume_height(MicroCore& mcore, uint64_t& next_height)
+    {
+        if (!m_has_progress)
+        {
+            return false;
+        }
+
+        Blockchain& core_storage = mcore.get_core();
+
+        uint64_t chain_height = core_storage.get_current_blockchain_height();
+
+        uint64_t oldest_height = m_last_height + 1 - m_recent_hashes.size();
+
+        while (!m_recent_hashes.empty())
+        {
+            uint64_t blk_height = oldest_height + m_recent_hashes.size() - 1;
+
+            if (blk_height < chain_height
+                && core_storage.get_block_id_by_height(blk_height)
+                   == m_recent_hashes.back())
+            {
+                break;
+            }
+
+            m_recent_hashes.pop_back();
+        }
+
+        if (m_recent_hashes.empty())
+        {
+            cerr << "Checkpoint " << m_file_path
+                 << " does not match the blockchain, starting a new scan." << endl;
+
+            m_has_progress = false;
+            m_records.clear();
+
+            return false;
+        }
+
+        uint64_t common_height = oldest_height + m_recent_hashes.size() - 1;
+
+        if (common_height != m_last_height)
+        {
+            cerr << "Blockchain reorganized after block " << common_height
+                 << ", rescanning from there." << endl;
+
+            m_records.erase(remove_if(m_records.begin(), m_records.end(),
+                                      [&](const checkpoint_record& rec)
+                                      {
+                                          return rec.blk_height > common_height;
+                                      }),
+                            m_records.end());
+
+            m_last_height = common_height;
+        }
+
+        next_height = m_last_height + 1;
+
+        return true;
+    }
+
+
+    /**
+     * Mark block as processed. Should be called after all
+     * records of the block are added, for consecutive blocks.
+     */
+    void
+    ScanCheckpoint::block_processed(uint64_t blk_height,
+                                    const crypto::hash& blk_hash)
+    {
+        // recent hashes must be of consecutive heights, ending
+        // at m_last_height, so start them over after a gap
+        if (m_has_progress && blk_height != m_last_height + 1)
+        {
+            m_recent_hashes.clear();
+        }
+
+        m_has_progress = true;
+        m_last_height  = blk_height;
+
+        m_recent_hashes.push_back(blk_hash);
+
+        if (m_recent_hashes.size() > RECENT_HASHES_NO)
+        {
+            m_recent_hashes.pop_front();
+        }
+    }
+
+
+    bool
+    ScanCheckpoint::has_progress() const
+    {
+        return m_has_progress;
+    }
+
+    uint64_t
+    ScanCheckpoint::last_height() const
+    {
+        return m_last_height;
+    }
+
+    void
+    ScanCheckpoint::add_record(uint64_t blk_height, const string& data)
+    {
+        m_records.push_back(checkpoint_record {blk_height, data});
+    }
+
+    const vector<checkpoint_record>&
+    ScanCheckpoint::records() const
+    {
+        return m_records;
+    }
+
+    const string&
+    ScanCheckpoint::file_path() const
+    {
+        return m_file_path;
+    }
+
+}
@@ -0,0 +1,103 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_SCANCHECKPOINT_H
+#define XMREG01_SCANCHECKPOINT_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * A partial result of a scan, found in a given block.
+     * data is mode specific, e.g., tx hash and output index
+     * of a found output.
+     */
+    struct checkpoint_record
+    {
+        uint64_t blk_height;
+        string   data;
+    };
+
+
+    /**
+     * Progress of a chain scan, saved in a small text file,
+     * so that an interrupted or a daily scan can continue from
+     * the last processed block instead of from the first one.
+     *
+     * Apart from the last height, hashes of the most recent
+     * blocks are kept. When resuming, they are compared with
+     * the blockchain to detect reorganizations, in which case
+     * the scan goes back to the last common block and
+     * records from the orphaned blocks are dropped.
+     *
+     * Totals, e.g., of found outputs, are not kept here, as
+     * scan modes compute them from the records, which can be
+     * rolled back block by block.
+     */
+    class ScanCheckpoint
+    {
+        static const size_t RECENT_HASHES_NO = 32;
+
+        string m_file_path;
+
+        // what is scanned, e.g., mode and address.
+        // Checkpoint of a different scan is not resumed.
+        string m_scan_id;
+
+        bool m_has_progress {false};
+
+        uint64_t m_last_height {0};
+
+        // hashes of the last processed blocks,
+        // the last one corresponds to m_last_height
+        deque<crypto::hash> m_recent_hashes;
+
+        vector<checkpoint_record> m_records;
+
+    public:
+
+        ScanCheckpoint(const string& file_path, const string& scan_id);
+
+        bool
+        load();
+
+        bool
+        save() const;
+
+        bool
+        resume_height(MicroCore& mcore, uint64_t& next_height);
+
+        void
+        block_processed(uint64_t blk_height, const crypto::hash& blk_hash);
+
+        bool
+        has_progress() const;
+
+        uint64_t
+        last_height() const;
+
+        void
+        add_record(uint64_t blk_height, const string& data);
+
+        const vector<checkpoint_record>&
+        records() const;
+
+        const string&
+        file_path() const;
+    };
+
+}
+
+#endif //XMREG01_SCANCHECKPOINT_H
@@ -0,0 +1,205 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "TxExtraReader.h"
+
+#include "common/varint.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace xmreg
+{
+
+    TxExtraReader::TxExtraReader(const vector<uint8_t>& extra)
+            : m_pos {extra.data()},
+              m_end {extra.data() + extra.size()}
+    {}
+
+
+    /**
+     * Read the next field, checking it the same
+     * way as the tx extra serialization does
+     *
+     * returns false at the end of extra, or if
+     * the field is malformed or unknown
+     */
+    bool
+    TxExtraReader::next(tx_extra_field_view& field)
+    {
+        if (m_failed || m_pos == m_end)
+        {
+            return false;
+        }
+
+        const uint8_t* first = m_pos + 1;
+
+        field.tag = *m_pos;
+
+        switch (field.tag)
+        {
+            case TX_EXTRA_TAG_PADDING:
+            {
+                // zeros till the end of extra
+                if (static_cast<size_t>(m_end - m_pos) > TX_EXTRA_PADDING_MAX_COUNT
+                    || find_if(first, m_end, [](uint8_t b) { return b != 0; }) != m_end)
+                {
+                    return fail();
+                }
+
+                field.size = m_end - first;
+                break;
+            }
+
+            case TX_EXTRA_TAG_PUBKEY:
+            {
+                if (static_cast<size_t>(m_end - first) < sizeof(public_key))
+                {
+                    return fail();
+                }
+
+                field.size = sizeof(public_key);
+                break;
+            }
+
+            case TX_EXTRA_NONCE:
+            case TX_EXTRA_MERGE_MINING_TAG:
+            case TX_EXTRA_MYSTERIOUS_MINERGATE_TAG:
+            {
+                // size prefixed blobs
+                uint64_t size;
+
+                if (tools::read_varint(first, m_end, size) <= 0
+                    || size > static_cast<uint64_t>(m_end - first)
+                    || (field.tag == TX_EXTRA_NONCE && size > TX_EXTRA_NONCE_MAX_COUNT))
+                {
+                    return fail();
+                }
+
+                field.size = size;
+                break;
+            }
+
+            default:
+                return fail();
+        }
+
+        field.data = first;
+
+        m_pos = first + field.size;
+
+        return true;
+    }
+
+
+    /**
+     * Whether reading stopped at a malformed
+     * or unknown field, not at the end of extra
+     */
+    bool
+    TxExtraReader::failed() const
+    {
+        return m_failed;
+    }
+
+
+    bool
+    TxExtraReader::fail()
+    {
+        m_failed = true;
+        return false;
+    }
+
+
+    /**
+     * Same as get_tx_pub_key_from_extra, i.e., the first
+     * tx public key in extra, or null_pkey if there is none
+     */
+    public_key
+    read_tx_pub_key(const transaction& tx)
+    {
+        TxExtraReader reader {tx.extra};
+
+        tx_extra_field_view field;
+
+        while (reader.next(field))
+        {
+            if (field.tag == TX_EXTRA_TAG_PUBKEY)
+            {
+                public_key pub_key;
+                memcpy(&pub_key, field.data, sizeof(pub_key));
+                return pub_key;
+            }
+        }
+
+        return null_pkey;
+    }
+
+
+    /**
+     * Find the first nonce in tx extra, which
+     * may have a payment id.
+     *
+     * The whole extra is read, and as with parse_tx_extra
+     * in get_payment_id, a malformed extra has no nonce,
+     * even if its nonce comes before the malformed field.
+     */
+    bool
+    read_tx_extra_nonce(const transaction& tx, tx_extra_field_view& nonce)
+    {
+        TxExtraReader reader {tx.extra};
+
+        tx_extra_field_view field;
+
+        bool found {false};
+
+        while (reader.next(field))
+        {
+            if (!found && field.tag == TX_EXTRA_NONCE)
+            {
+                nonce = field;
+                found = true;
+            }
+        }
+
+        return found && !reader.failed();
+    }
+
+
+    /**
+     * Same as get_payment_id_from_tx_extra_nonce,
+     * without copying the nonce into a string
+     */
+    bool
+    nonce_payment_id(const tx_extra_field_view& nonce,
+                     crypto::hash& payment_id)
+    {
+        if (nonce.size != sizeof(crypto::hash) + 1
+            || nonce.data[0] != TX_EXTRA_NONCE_PAYMENT_ID)
+        {
+            return false;
+        }
+
+        memcpy(&payment_id, nonce.data + 1, sizeof(crypto::hash));
+
+        return true;
+    }
+
+    bool
+    nonce_encrypted_payment_id(const tx_extra_field_view& nonce,
+                               crypto::hash8& payment_id8)
+    {
+        if (nonce.size != sizeof(crypto::hash8) + 1
+            || nonce.data[0] != TX_EXTRA_NONCE_ENCRYPTED_PAYMENT_ID)
+        {
+            return false;
+        }
+
+        memcpy(&payment_id8, nonce.data + 1, sizeof(crypto::hash8));
+
+        return true;
+    }
+
+}
@@ -0,0 +1,83 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_TXEXTRAREADER_H
+#define XMREG01_TXEXTRAREADER_H
+
+#include "monero_headers.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Field of tx extra, pointing into the extra itself,
+     * i.e., its tag and its data without the size prefix
+     */
+    struct tx_extra_field_view
+    {
+        uint8_t        tag {0};
+        const uint8_t* data {nullptr};
+        size_t         size {0};
+    };
+
+
+    /**
+     * Reads fields of tx extra one after another, in place.
+     *
+     * Unlike parse_tx_extra, it builds no vector of variants
+     * and copies nothing, so it can be used for every tx in
+     * chain-wide scans. Fields after the one needed are not
+     * read at all.
+     *
+     * Reading stops at the first malformed or unknown field,
+     * but fields before it are given, as with parse_tx_extra.
+     */
+    class TxExtraReader
+    {
+        const uint8_t* m_pos;
+        const uint8_t* m_end;
+
+        bool m_failed {false};
+
+    public:
+
+        explicit TxExtraReader(const vector<uint8_t>& extra);
+
+        bool
+        next(tx_extra_field_view& field);
+
+        bool
+        failed() const;
+
+    private:
+
+        bool
+        fail();
+    };
+
+
+    public_key
+    read_tx_pub_key(const transaction& tx);
+
+    bool
+    read_tx_extra_nonce(const transaction& tx, tx_extra_field_view& nonce);
+
+    bool
+    nonce_payment_id(const tx_extra_field_view& nonce,
+                     crypto::hash& payment_id);
+
+    bool
+    nonce_encrypted_payment_id(const tx_extra_field_view& nonce,
+                               crypto::hash8& payment_id8);
+
+}
+
+#endif //XMREG01_TXEXTRAREADER_H
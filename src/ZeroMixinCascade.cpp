@@ -0,0 +1,154 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "ZeroMixinCascade.h"
+
+
+namespace xmreg
+{
+
+    /**
+     * The graph must have its reverse graph built,
+     * i.e., RingGraph::build_reverse() called.
+     */
+    ZeroMixinCascade::ZeroMixinCascade(const RingGraph& graph)
+            : m_graph {graph}
+    {}
+
+
+    /**
+     * Propagate spent outputs through the rings until
+     * a fixed point is reached.
+     *
+     * A worklist holds inputs with a single candidate left.
+     * Each input is put on it at most once, i.e., when its
+     * candidate count drops to one, so the whole run is linear
+     * in the number of ring members.
+     *
+     * returns number of inputs which real outputs were found
+     */
+    size_t
+    ZeroMixinCascade::run()
+    {
+        m_spent_by.assign(m_graph.output_no(), RingGraph::NO_ID);
+        m_candidate_no.resize(m_graph.input_no());
+
+        m_deduced_no = 0;
+
+        vector<uint32_t> worklist;
+
+        for (size_t input_id = 0; input_id < m_graph.input_no(); ++input_id)
+        {
+            m_candidate_no[input_id] = static_cast<uint32_t>(m_graph.ring(input_id).size());
+
+            if (m_candidate_no[input_id] == 1)
+            {
+                worklist.push_back(static_cast<uint32_t>(input_id));
+            }
+        }
+
+        while (!worklist.empty())
+        {
+            uint32_t input_id = worklist.back();
+            worklist.pop_back();
+
+            // find the only member not spent by other input
+            uint32_t real_id {RingGraph::NO_ID};
+
+            for (uint32_t output_id: m_graph.ring(input_id))
+            {
+                if (m_spent_by[output_id] == RingGraph::NO_ID)
+                {
+                    real_id = output_id;
+                    break;
+                }
+            }
+
+            if (real_id == RingGraph::NO_ID)
+            {
+                // all members spent elsewhere. Should not
+                // happen with a valid blockchain.
+                continue;
+            }
+
+            m_spent_by[real_id] = input_id;
+            ++m_deduced_no;
+
+            // remove the output from all other rings
+            for (uint32_t other_id: m_graph.referencing_inputs(real_id))
+            {
+                if (other_id == input_id || m_candidate_no[other_id] == 0)
+                {
+                    continue;
+                }
+
+                if (--m_candidate_no[other_id] == 1)
+                {
+                    worklist.push_back(other_id);
+                }
+            }
+        }
+
+        return m_deduced_no;
+    }
+
+
+    /**
+     * returns input known to spend the given output, or NO_ID
+     */
+    uint32_t
+    ZeroMixinCascade::spending_input(uint32_t output_id) const
+    {
+        if (output_id >= m_spent_by.size())
+        {
+            return RingGraph::NO_ID;
+        }
+
+        return m_spent_by[output_id];
+    }
+
+
+    /**
+     * Is the ring member of the given input provably
+     * spent by some other input, i.e., it's a decoy.
+     */
+    bool
+    ZeroMixinCascade::is_spent_elsewhere(uint32_t output_id, uint32_t input_id) const
+    {
+        uint32_t spending_id = spending_input(output_id);
+
+        return spending_id != RingGraph::NO_ID && spending_id != input_id;
+    }
+
+
+    /**
+     * returns real output of the given input, or NO_ID if unknown
+     */
+    uint32_t
+    ZeroMixinCascade::real_output(uint32_t input_id) const
+    {
+        if (input_id >= m_candidate_no.size())
+        {
+            return RingGraph::NO_ID;
+        }
+
+        for (uint32_t output_id: m_graph.ring(input_id))
+        {
+            if (m_spent_by[output_id] == input_id)
+            {
+                return output_id;
+            }
+        }
+
+        return RingGraph::NO_ID;
+    }
+
+
+    size_t
+    ZeroMixinCascade::deduced_no() const
+    {
+        return m_deduced_no;
+    }
+
+}
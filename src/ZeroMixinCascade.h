@@ -0,0 +1,68 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_ZEROMIXINCASCADE_H
+#define XMREG01_ZEROMIXINCASCADE_H
+
+#include "RingGraph.h"
+
+#include <vector>
+
+namespace xmreg
+{
+    using namespace std;
+
+
+    /**
+     * Finds real outputs spent by inputs, starting from
+     * zero-mixin inputs, which spend their only ring member.
+     *
+     * An output spent by one input can't be the real one in
+     * any other ring, so it is removed from all rings
+     * referencing it. Inputs left with a single candidate become
+     * known as well, and their outputs are removed in turn.
+     * This is repeated until nothing changes, i.e., a fixed
+     * point is reached.
+     *
+     * Per output, only id of the input known to spend it is kept,
+     * and per input, the number of its remaining candidates.
+     * Both are 32-bit, so memory is bounded by the size of the
+     * ring graph itself.
+     */
+    class ZeroMixinCascade
+    {
+        const RingGraph& m_graph;
+
+        // input known to spend each output, or NO_ID
+        vector<uint32_t> m_spent_by;
+
+        // number of ring members of each input
+        // not known to be spent elsewhere
+        vector<uint32_t> m_candidate_no;
+
+        size_t m_deduced_no {0};
+
+    public:
+
+        ZeroMixinCascade(const RingGraph& graph);
+
+        size_t
+        run();
+
+        uint32_t
+        spending_input(uint32_t output_id) const;
+
+        bool
+        is_spent_elsewhere(uint32_t output_id, uint32_t input_id) const;
+
+        uint32_t
+        real_output(uint32_t input_id) const;
+
+        size_t
+        deduced_no() const;
+    };
+
+}
+
+#endif //XMREG01_ZEROMIXINCASCADE_H
@@ -0,0 +1,276 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "chain_scan.h"
+
+#include "parallel.h"
+
+#include <csignal>
+#include <atomic>
+#include <limits>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        volatile sig_atomic_t stop_signal_received {0};
+
+        extern "C" void
+        on_stop_signal(int)
+        {
+            stop_signal_received = 1;
+        }
+    }
+
+
+    /**
+     * Catch SIGINT and SIGTERM, so that long scans
+     * can save their progress before finishing
+     */
+    void
+    install_stop_handlers()
+    {
+        signal(SIGINT,  on_stop_signal);
+        signal(SIGTERM, on_stop_signal);
+    }
+
+
+    bool
+    stop_requested()
+    {
+        return stop_signal_received != 0;
+    }
+
+
+    /**
+     * Call process_block for each block in the given height range,
+     * together with all its transactions.
+     *
+     * If checkpoint is given, it is updated after each block and
+     * saved every checkpoint_interval blocks, at the end of the
+     * range, and when a stop signal is received.
+     *
+     * The scan also stops, with the checkpoint saved, at a block
+     * which cant be read, so that the checkpoint never moves past
+     * it and a resumed scan reads it again.
+     *
+     * returns false if the scan was stopped before reaching to_height
+     */
+    bool
+    scan_blocks(MicroCore& mcore,
+                uint64_t from_height,
+                uint64_t to_height,
+                const block_processor& process_block,
+                ScanCheckpoint* checkpoint,
+                uint64_t checkpoint_interval)
+    {
+        uint64_t blocks_since_save {0};
+
+        for (uint64_t blk_height = from_height; blk_height <= to_height; ++blk_height)
+        {
+            if (stop_requested())
+            {
+                if (checkpoint)
+                {
+                    checkpoint->save();
+                }
+
+                return false;
+            }
+
+            block blk;
+            list<transaction> txs;
+
+            if (!mcore.get_block_by_height(blk_height, blk)
+                || !mcore.get_block_txs(blk, txs))
+            {
+                cerr << "Cant read block or its transactions: " << blk_height << endl;
+
+                if (checkpoint)
+                {
+                    checkpoint->save();
+                }
+
+                return false;
+            }
+
+            process_block(blk_height, blk, txs);
+
+            if (checkpoint)
+            {
+                checkpoint->block_processed(blk_height, get_block_hash(blk));
+
+                if (++blocks_since_save >= checkpoint_interval)
+                {
+                    checkpoint->save();
+                    blocks_since_save = 0;
+                }
+            }
+        }
+
+        if (checkpoint)
+        {
+            checkpoint->save();
+        }
+
+        return true;
+    }
+
+
+
+    /**
+     * Number of chunks of chunk_size blocks
+     * in the given height range
+     */
+    size_t
+    get_chunk_no(uint64_t from_height,
+                 uint64_t to_height,
+                 uint64_t chunk_size)
+    {
+        if (to_height < from_height || chunk_size == 0)
+        {
+            return 0;
+        }
+
+        return (to_height - from_height) / chunk_size + 1;
+    }
+
+
+    /**
+     * Same as scan_blocks, but blocks are processed in parallel.
+     *
+     * The height range is split into chunks of chunk_size blocks.
+     * Threads take the next unprocessed chunk when they are done
+     * with the current one, as the number of txs per block
+     * varies a lot along the blockchain. Blocks within a chunk
+     * are processed in order, and chunk_idx is given to
+     * process_block, so that results can be collected per chunk
+     * and merged in height order at the end.
+     *
+     * All threads stop at the first block, or its txs, which
+     * cant be read, so that no incomplete result is taken as
+     * a complete one. Its height is put in failed_height, if given.
+     *
+     * returns false if the scan was stopped by a signal,
+     * or by a block which could not be read
+     */
+    bool
+    parallel_scan_blocks(MicroCore& mcore,
+                         uint64_t from_height,
+                         uint64_t to_height,
+                         uint64_t chunk_size,
+                         const chunk_block_processor& process_block,
+                         size_t thread_no,
+                         uint64_t* failed_height)
+    {
+        size_t chunk_no = get_chunk_no(from_height, to_height, chunk_size);
+
+        atomic<size_t> next_chunk {0};
+
+        atomic<bool> failed {false};
+
+        // lowest height which could not be read
+        atomic<uint64_t> first_failed_height {numeric_limits<uint64_t>::max()};
+
+        parallel_chunks(get_thread_no(thread_no), [&](size_t, size_t, size_t)
+        {
+            size_t chunk_idx;
+
+            while ((chunk_idx = next_chunk++) < chunk_no && !stop_requested() && !failed)
+            {
+                uint64_t chunk_from = from_height + chunk_idx * chunk_size;
+                uint64_t chunk_to   = min(to_height, chunk_from + chunk_size - 1);
+
+                for (uint64_t blk_height = chunk_from;
+                     blk_height <= chunk_to && !failed; ++blk_height)
+                {
+                    block blk;
+                    list<transaction> txs;
+
+                    if (!mcore.get_block_by_height(blk_height, blk)
+                        || !mcore.get_block_txs(blk, txs))
+                    {
+                        cerr << "Cant read block or its transactions: " << blk_height << endl;
+
+                        uint64_t lowest = first_failed_height;
+
+                        while (blk_height < lowest
+                               && !first_failed_height.compare_exchange_weak(lowest, blk_height))
+                        {}
+
+                        failed = true;
+                        break;
+                    }
+
+                    process_block(chunk_idx, blk_height, blk, txs);
+                }
+            }
+        }, thread_no);
+
+        if (failed && failed_height)
+        {
+            *failed_height = first_failed_height;
+        }
+
+        return !failed && !stop_requested();
+    }
+
+
+    /**
+     * Call process_ring for ring of each non-coinbase input
+     * in the given height range. Blocks are read in parallel
+     * as in parallel_scan_blocks.
+     */
+    bool
+    parallel_scan_rings(MicroCore& mcore,
+                        uint64_t from_height,
+                        uint64_t to_height,
+                        uint64_t chunk_size,
+                        const chunk_ring_processor& process_ring,
+                        size_t thread_no)
+    {
+        return parallel_scan_blocks(mcore, from_height, to_height, chunk_size,
+                                    [&](size_t chunk_idx, uint64_t blk_height,
+                                        const block& blk,
+                                        const list<transaction>& txs)
+        {
+            input_ring ring;
+
+            ring.blk_height = blk_height;
+
+            for (const transaction& tx: txs)
+            {
+                bool tx_hash_known {false};
+
+                for (size_t in_i = 0; in_i < tx.vin.size(); ++in_i)
+                {
+                    if (tx.vin[in_i].type() != typeid(txin_to_key))
+                    {
+                        continue;
+                    }
+
+                    const txin_to_key& tx_in_to_key
+                            = boost::get<txin_to_key>(tx.vin[in_i]);
+
+                    if (!tx_hash_known)
+                    {
+                        ring.tx_hash  = get_transaction_hash(tx);
+                        tx_hash_known = true;
+                    }
+
+                    ring.in_i    = in_i;
+                    ring.k_image = tx_in_to_key.k_image;
+                    ring.amount  = tx_in_to_key.amount;
+                    ring.absolute_offsets
+                            = relative_output_offsets_to_absolute(tx_in_to_key.key_offsets);
+
+                    process_ring(chunk_idx, ring);
+                }
+            }
+        }, thread_no);
+    }
+
+}
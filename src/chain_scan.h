@@ -0,0 +1,90 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_CHAIN_SCAN_H
+#define XMREG01_CHAIN_SCAN_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "ScanCheckpoint.h"
+
+#include <functional>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    using block_processor = function<void(uint64_t blk_height,
+                                          const block& blk,
+                                          const list<transaction>& txs)>;
+
+    using chunk_block_processor = function<void(size_t chunk_idx,
+                                                uint64_t blk_height,
+                                                const block& blk,
+                                                const list<transaction>& txs)>;
+
+
+    /**
+     * Ring of a single input, i.e., global indices
+     * of outputs it may be spending.
+     *
+     * member_heights, i.e., heights of blocks with the ring
+     * members, are only given if the ring source resolves them
+     */
+    struct input_ring
+    {
+        uint64_t         blk_height;
+        crypto::hash     tx_hash;
+        size_t           in_i;
+        key_image        k_image;
+        uint64_t         amount;
+        vector<uint64_t> absolute_offsets;
+        vector<uint64_t> member_heights;
+    };
+
+    using chunk_ring_processor = function<void(size_t chunk_idx,
+                                               const input_ring& ring)>;
+
+    void
+    install_stop_handlers();
+
+    bool
+    stop_requested();
+
+    bool
+    scan_blocks(MicroCore& mcore,
+                uint64_t from_height,
+                uint64_t to_height,
+                const block_processor& process_block,
+                ScanCheckpoint* checkpoint = nullptr,
+                uint64_t checkpoint_interval = 1000);
+
+    size_t
+    get_chunk_no(uint64_t from_height,
+                 uint64_t to_height,
+                 uint64_t chunk_size);
+
+    bool
+    parallel_scan_blocks(MicroCore& mcore,
+                         uint64_t from_height,
+                         uint64_t to_height,
+                         uint64_t chunk_size,
+                         const chunk_block_processor& process_block,
+                         size_t thread_no = 0,
+                         uint64_t* failed_height = nullptr);
+
+    bool
+    parallel_scan_rings(MicroCore& mcore,
+                        uint64_t from_height,
+                        uint64_t to_height,
+                        uint64_t chunk_size,
+                        const chunk_ring_processor& process_ring,
+                        size_t thread_no = 0);
+
+}
+
+#endif //XMREG01_CHAIN_SCAN_H
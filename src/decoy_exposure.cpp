@@ -0,0 +1,116 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "decoy_exposure.h"
+
+#include <unordered_map>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        // (amount, global index) of an output
+        using output_ref = pair<uint64_t, uint64_t>;
+
+        struct output_ref_hash
+        {
+            size_t
+            operator()(const output_ref& ref) const
+            {
+                return std::hash<uint64_t>()(ref.first * 0x9e3779b97f4a7c15ULL ^ ref.second);
+            }
+        };
+    }
+
+
+    /**
+     * Get global index, i.e., index among outputs
+     * of the same amount, of each of the given outputs
+     */
+    bool
+    get_global_indices(MicroCore& mcore,
+                       const vector<transfer_details>& outputs,
+                       vector<uint64_t>& global_indices)
+    {
+        global_indices.clear();
+        global_indices.reserve(outputs.size());
+
+        vector<uint64_t> tx_indices;
+
+        for (const transfer_details& td: outputs)
+        {
+            if (!mcore.get_core().get_tx_outputs_gindexs(td.tx_hash(), tx_indices)
+                || td.m_internal_output_index >= tx_indices.size())
+            {
+                cerr << "Cant get global index of output " << td.m_internal_output_index
+                     << " of tx " << td.tx_hash() << endl;
+                return false;
+            }
+
+            global_indices.push_back(tx_indices[td.m_internal_output_index]);
+        }
+
+        return true;
+    }
+
+
+    /**
+     * Find all rings, given by the source, which reference
+     * any of the given outputs, in a single pass.
+     *
+     * Rings are checked against a hash set of (amount, global
+     * index) of the outputs, so the pass takes the same time
+     * for one output as for thousands of them. Ring uses are
+     * returned in height order.
+     *
+     * returns false if the scan was stopped by a signal
+     */
+    bool
+    find_output_ring_uses(const RingSource& source,
+                          const vector<transfer_details>& outputs,
+                          const vector<uint64_t>& global_indices,
+                          vector<output_ring_use>& ring_uses,
+                          size_t thread_no)
+    {
+        unordered_map<output_ref, size_t, output_ref_hash> output_idxs;
+
+        output_idxs.reserve(outputs.size());
+
+        for (size_t i = 0; i < outputs.size(); ++i)
+        {
+            output_idxs.emplace(output_ref {outputs[i].amount(), global_indices[i]}, i);
+        }
+
+        vector<vector<output_ring_use>> chunks(source.chunk_no());
+
+        bool completed = source.scan([&](size_t chunk_idx, const input_ring& ring)
+        {
+            for (uint64_t global_index: ring.absolute_offsets)
+            {
+                auto it = output_idxs.find(output_ref {ring.amount, global_index});
+
+                if (it == output_idxs.end())
+                {
+                    continue;
+                }
+
+                chunks[chunk_idx].push_back(output_ring_use {
+                        it->second, ring.blk_height, ring.tx_hash, ring.in_i,
+                        ring.k_image, ring.absolute_offsets.size()});
+            }
+        }, thread_no);
+
+        ring_uses.clear();
+
+        for (const vector<output_ring_use>& chunk: chunks)
+        {
+            ring_uses.insert(ring_uses.end(), chunk.begin(), chunk.end());
+        }
+
+        return completed;
+    }
+
+}
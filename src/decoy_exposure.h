@@ -0,0 +1,54 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_DECOY_EXPOSURE_H
+#define XMREG01_DECOY_EXPOSURE_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "RingSource.h"
+#include "tx_details.h"
+
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Ring of an input which references one of our outputs,
+     * i.e., output_idx of the outputs searched for.
+     *
+     * tx_hash is null if the ring source does not keep
+     * tx hashes, e.g., a RingCache.
+     */
+    struct output_ring_use
+    {
+        size_t       output_idx;
+        uint64_t     blk_height;
+        crypto::hash tx_hash;
+        size_t       in_i;
+        key_image    k_image;
+        size_t       ring_size;
+    };
+
+
+    bool
+    get_global_indices(MicroCore& mcore,
+                       const vector<transfer_details>& outputs,
+                       vector<uint64_t>& global_indices);
+
+    bool
+    find_output_ring_uses(const RingSource& source,
+                          const vector<transfer_details>& outputs,
+                          const vector<uint64_t>& global_indices,
+                          vector<output_ring_use>& ring_uses,
+                          size_t thread_no = 0);
+
+}
+
+#endif //XMREG01_DECOY_EXPOSURE_H
@@ -0,0 +1,128 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "hash_file.h"
+#include "MappedFile.h"
+#include "hex.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <sys/stat.h>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        // bad lines are shown only up to this length
+        const size_t MAX_BAD_LINE_SIZE {80};
+
+        inline bool
+        is_blank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+    }
+
+
+    /**
+     * Read hashes, e.g., of txs, one per line in hex, from
+     * the given file into a contiguous array.
+     *
+     * The file is memory mapped and decoded in place, without
+     * a string per line. Blank lines are skipped, and leading
+     * and trailing spaces, including '\r', are ignored.
+     *
+     * Lines which are not hashes are returned in bad_lines,
+     * with their line numbers counted from 1, and are
+     * not added to hashes.
+     *
+     * An empty file has no hashes, and is not an error.
+     *
+     * returns false if the file cant be read
+     */
+    bool
+    read_hash_file(const string& file_path,
+                   vector<crypto::hash>& hashes,
+                   vector<bad_hash_line>& bad_lines)
+    {
+        struct stat file_stat;
+
+        // empty files cant be memory mapped
+        if (stat(file_path.c_str(), &file_stat) == 0
+            && S_ISREG(file_stat.st_mode) && file_stat.st_size == 0)
+        {
+            return true;
+        }
+
+        MappedFile file;
+
+        if (!file.open(file_path))
+        {
+            cerr << "Cant read hashes from: " << file_path << endl;
+            return false;
+        }
+
+        const size_t hex_size = 2 * sizeof(crypto::hash);
+
+        // most lines are a hash and a newline
+        hashes.reserve(hashes.size() + file.size() / (hex_size + 1) + 1);
+
+        const char* pos = file.data();
+        const char* end = file.data() + file.size();
+
+        size_t line_no {0};
+
+        while (pos < end)
+        {
+            ++line_no;
+
+            const char* line_end = static_cast<const char*>(
+                    memchr(pos, '\n', end - pos));
+
+            if (!line_end)
+            {
+                line_end = end;
+            }
+
+            const char* first = pos;
+            const char* last  = line_end;
+
+            pos = line_end + 1;
+
+            while (first < last && is_blank(*first))
+            {
+                ++first;
+            }
+
+            while (last > first && is_blank(*(last - 1)))
+            {
+                --last;
+            }
+
+            if (first == last)
+            {
+                continue;
+            }
+
+            crypto::hash hash;
+
+            if (static_cast<size_t>(last - first) != hex_size
+                || !hex_decode(first, hex_size, &hash))
+            {
+                bad_lines.push_back(bad_hash_line {
+                        line_no,
+                        string(first, min<size_t>(last - first, MAX_BAD_LINE_SIZE))});
+                continue;
+            }
+
+            hashes.push_back(hash);
+        }
+
+        return true;
+    }
+
+}
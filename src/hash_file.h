@@ -0,0 +1,35 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_HASH_FILE_H
+#define XMREG01_HASH_FILE_H
+
+#include "monero_headers.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace std;
+
+
+    /**
+     * Line of a hash file that is not a 64-char hex hash
+     */
+    struct bad_hash_line
+    {
+        size_t line_no;
+        string line;
+    };
+
+
+    bool
+    read_hash_file(const string& file_path,
+                   vector<crypto::hash>& hashes,
+                   vector<bad_hash_line>& bad_lines);
+
+}
+
+#endif //XMREG01_HASH_FILE_H
@@ -0,0 +1,406 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "hex.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define XMREG_HEX_AVX2
+#endif
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        const char HEX_DIGITS[] = "0123456789abcdef";
+
+        using hex_encoder = size_t (*)(const void*, size_t, char*);
+
+
+        /**
+         * returns value of a hex digit, or -1 if c is not one
+         */
+        inline int
+        hex_digit_value(char c)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                return c - '0';
+            }
+
+            if (c >= 'a' && c <= 'f')
+            {
+                return c - 'a' + 10;
+            }
+
+            if (c >= 'A' && c <= 'F')
+            {
+                return c - 'A' + 10;
+            }
+
+            return -1;
+        }
+
+
+#if defined(__SSE2__)
+        /**
+         * Hex of each nibble of 16 bytes, i.e., '0' + n,
+         * plus 39 more for 'a'-'f', interleaved as
+         * high nibble first
+         */
+        inline void
+        hex_encode_16(const char* in, char* out)
+        {
+            const __m128i mask_0f = _mm_set1_epi8(0x0f);
+            const __m128i nine    = _mm_set1_epi8(9);
+            const __m128i zero    = _mm_set1_epi8('0');
+            const __m128i letters = _mm_set1_epi8('a' - '0' - 10);
+
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask_0f);
+            __m128i lo = _mm_and_si128(bytes, mask_0f);
+
+            hi = _mm_add_epi8(_mm_add_epi8(hi, zero),
+                              _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letters));
+            lo = _mm_add_epi8(_mm_add_epi8(lo, zero),
+                              _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letters));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                             _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16),
+                             _mm_unpackhi_epi8(hi, lo));
+        }
+
+        size_t
+        hex_encode_sse2(const void* data, size_t size, char* out)
+        {
+            const char* in = static_cast<const char*>(data);
+
+            size_t i {0};
+
+            for (; i + 16 <= size; i += 16)
+            {
+                hex_encode_16(in + i, out + 2 * i);
+            }
+
+            hex_encode_scalar(in + i, size - i, out + 2 * i);
+
+            return 2 * size;
+        }
+#endif
+
+
+#if defined(__SSE2__)
+        /**
+         * Check that 16 chars are hex digits and turn them
+         * into 8 bytes, i.e., each char into its nibble,
+         * and then each pair of nibbles into a byte
+         */
+        inline bool
+        hex_decode_16(const char* in, unsigned char* out)
+        {
+            __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+
+            // 'A'-'F' to 'a'-'f', digits stay as they are
+            __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+
+            __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                             _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars));
+            __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                             _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+
+            if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff)
+            {
+                return false;
+            }
+
+            __m128i nibbles = _mm_or_si128(
+                    _mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                    _mm_andnot_si128(is_digit, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+
+            // high nibble is the first char of a pair,
+            // i.e., the low byte of each 16-bit lane
+            __m128i bytes = _mm_or_si128(
+                    _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00f0)),
+                    _mm_srli_epi16(nibbles, 8));
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(bytes, bytes));
+
+            return true;
+        }
+#endif
+
+
+#if defined(XMREG_HEX_AVX2)
+        /**
+         * Same as the SSE2 version, but 32 bytes, e.g., a whole
+         * key or hash, at a time. Unpacking works within 128-bit
+         * lanes, so the lanes are put back in order at the end.
+         */
+        __attribute__((target("avx2")))
+        size_t
+        hex_encode_avx2(const void* data, size_t size, char* out)
+        {
+            const char* in = static_cast<const char*>(data);
+
+            const __m256i mask_0f = _mm256_set1_epi8(0x0f);
+            const __m256i nine    = _mm256_set1_epi8(9);
+            const __m256i zero    = _mm256_set1_epi8('0');
+            const __m256i letters = _mm256_set1_epi8('a' - '0' - 10);
+
+            size_t i {0};
+
+            for (; i + 32 <= size; i += 32)
+            {
+                __m256i bytes = _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i*>(in + i));
+
+                __m256i hi = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), mask_0f);
+                __m256i lo = _mm256_and_si256(bytes, mask_0f);
+
+                hi = _mm256_add_epi8(_mm256_add_epi8(hi, zero),
+                                     _mm256_and_si256(_mm256_cmpgt_epi8(hi, nine), letters));
+                lo = _mm256_add_epi8(_mm256_add_epi8(lo, zero),
+                                     _mm256_and_si256(_mm256_cmpgt_epi8(lo, nine), letters));
+
+                __m256i first  = _mm256_unpacklo_epi8(hi, lo);
+                __m256i second = _mm256_unpackhi_epi8(hi, lo);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i),
+                                    _mm256_permute2x128_si256(first, second, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32),
+                                    _mm256_permute2x128_si256(first, second, 0x31));
+            }
+
+            hex_encode_scalar(in + i, size - i, out + 2 * i);
+
+            return 2 * size;
+        }
+#endif
+
+
+        hex_encoder
+        select_hex_encoder()
+        {
+#if defined(XMREG_HEX_AVX2)
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return hex_encode_avx2;
+            }
+#endif
+
+#if defined(__SSE2__)
+            return hex_encode_sse2;
+#else
+            return hex_encode_scalar;
+#endif
+        }
+
+
+        /**
+         * Format pod as hex in angle brackets, as its
+         * operator<< does, keeping width and alignment
+         * given in the format string
+         */
+        template <typename POD>
+        void
+        format_pod(fmt::BasicFormatter<char>& f, const char*& format_str, const POD& pod)
+        {
+            array<char, 2 * sizeof(POD) + 2> buffer;
+
+            buffer.front() = '<';
+            hex_encode(&pod, sizeof(POD), &buffer[1]);
+            buffer.back()  = '>';
+
+            fmt::StringRef str {buffer.data(), buffer.size()};
+
+            fmt::internal::Arg arg = fmt::internal::MakeValue<char>(str);
+            arg.type = static_cast<fmt::internal::Arg::Type>(
+                    fmt::internal::MakeValue<char>::type(str));
+
+            format_str = f.format(format_str, arg);
+        }
+    }
+
+
+    size_t
+    hex_encode_scalar(const void* data, size_t size, char* out)
+    {
+        const unsigned char* in = static_cast<const unsigned char*>(data);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            out[2 * i]     = HEX_DIGITS[in[i] >> 4];
+            out[2 * i + 1] = HEX_DIGITS[in[i] & 0x0f];
+        }
+
+        return 2 * size;
+    }
+
+
+    size_t
+    hex_encode(const void* data, size_t size, char* out)
+    {
+        // cpu features are checked only once
+        static const hex_encoder encoder = select_hex_encoder();
+
+        return encoder(data, size, out);
+    }
+
+
+    bool
+    hex_decode_scalar(const char* hex, size_t size, void* out)
+    {
+        unsigned char* bytes = static_cast<unsigned char*>(out);
+
+        for (size_t i = 0; i + 1 < size; i += 2)
+        {
+            int hi = hex_digit_value(hex[i]);
+            int lo = hex_digit_value(hex[i + 1]);
+
+            if (hi < 0 || lo < 0)
+            {
+                return false;
+            }
+
+            bytes[i / 2] = static_cast<unsigned char>(hi << 4 | lo);
+        }
+
+        return true;
+    }
+
+
+    bool
+    hex_decode(const char* hex, size_t size, void* out)
+    {
+        size_t i {0};
+
+#if defined(__SSE2__)
+        unsigned char* bytes = static_cast<unsigned char*>(out);
+
+        for (; i + 16 <= size; i += 16)
+        {
+            if (!hex_decode_16(hex + i, bytes + i / 2))
+            {
+                return false;
+            }
+        }
+
+        return hex_decode_scalar(hex + i, size - i, bytes + i / 2);
+#else
+        return hex_decode_scalar(hex + i, size, out);
+#endif
+    }
+
+
+    /**
+     * Hex encode key_no random 32-byte keys using
+     * epee::string_tools::pod_to_hex and hex_encode,
+     * and compare time taken.
+     *
+     * returns time in seconds of epee and of hex_encode
+     */
+    array<double, 2>
+    benchmark_hex_encoding(size_t key_no)
+    {
+        using clock = chrono::steady_clock;
+
+        // random keys, so no blockchain is needed
+        vector<crypto::hash> keys(key_no);
+
+        mt19937 rng(key_no);
+
+        for (crypto::hash& key: keys)
+        {
+            for (size_t i = 0; i < sizeof(key); ++i)
+            {
+                reinterpret_cast<char*>(&key)[i] = static_cast<char>(rng());
+            }
+        }
+
+        // use the output, so the loops are not optimized away
+        size_t checksum_a {0}, checksum_b {0};
+
+        auto t0 = clock::now();
+
+        for (const crypto::hash& key: keys)
+        {
+            string hex = epee::string_tools::pod_to_hex(key);
+            checksum_a += static_cast<unsigned char>(hex[hex.size() / 2]);
+        }
+
+        auto t1 = clock::now();
+
+        array<char, 2 * sizeof(crypto::hash)> buffer;
+
+        for (const crypto::hash& key: keys)
+        {
+            hex_encode(&key, sizeof(key), buffer.data());
+            checksum_b += static_cast<unsigned char>(buffer[buffer.size() / 2]);
+        }
+
+        auto t2 = clock::now();
+
+        // both ways must give same hex
+        for (size_t i = 0; i < min<size_t>(key_no, 1000); ++i)
+        {
+            if (pod_to_hex(keys[i]) != epee::string_tools::pod_to_hex(keys[i]))
+            {
+                cerr << "Hex of key " << i << " differs from epee's one" << endl;
+                break;
+            }
+        }
+
+        if (checksum_a != checksum_b)
+        {
+            cerr << "Hex encoding checksums differ" << endl;
+        }
+
+        return {chrono::duration<double>(t1 - t0).count(),
+                chrono::duration<double>(t2 - t1).count()};
+    }
+
+}
+
+
+namespace crypto
+{
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const public_key& key)
+    {
+        xmreg::format_pod(f, format_str, key);
+    }
+
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const key_image& k_image)
+    {
+        xmreg::format_pod(f, format_str, k_image);
+    }
+
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const hash& h)
+    {
+        xmreg::format_pod(f, format_str, h);
+    }
+
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const signature& sig)
+    {
+        xmreg::format_pod(f, format_str, sig);
+    }
+}
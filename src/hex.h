@@ -0,0 +1,89 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_HEX_H
+#define XMREG01_HEX_H
+
+#include "monero_headers.h"
+
+#include "../ext/format.h"
+
+#include <string>
+#include <array>
+
+namespace xmreg
+{
+    using namespace std;
+
+
+    /**
+     * Write hex of size bytes of data into out, which
+     * must have room for 2 * size chars. No null is added.
+     *
+     * Uses AVX2 or SSE2 when the cpu has them,
+     * and a lookup table otherwise.
+     *
+     * returns number of chars written
+     */
+    size_t
+    hex_encode(const void* data, size_t size, char* out);
+
+    size_t
+    hex_encode_scalar(const void* data, size_t size, char* out);
+
+    /**
+     * Read size hex chars, upper or lower case, into
+     * size / 2 bytes of out. size must be even.
+     *
+     * Uses SSE2 when available, 16 chars at a time.
+     *
+     * returns false if any char is not a hex digit
+     */
+    bool
+    hex_decode(const char* hex, size_t size, void* out);
+
+    bool
+    hex_decode_scalar(const char* hex, size_t size, void* out);
+
+    /**
+     * Same as epee::string_tools::pod_to_hex, but
+     * without going through a stringstream
+     */
+    template <typename POD>
+    string
+    pod_to_hex(const POD& pod)
+    {
+        string hex(2 * sizeof(POD), '\0');
+        hex_encode(&pod, sizeof(POD), &hex[0]);
+        return hex;
+    }
+
+    array<double, 2>
+    benchmark_hex_encoding(size_t key_no);
+
+}
+
+
+/**
+ * fmt formatting of keys, hashes and signatures, used by
+ * fmt::print instead of their operator<<. Output is the
+ * same, i.e., hex in angle brackets, but is written
+ * directly into fmt's buffer.
+ */
+namespace crypto
+{
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const public_key& key);
+
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const key_image& k_image);
+
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const hash& h);
+
+    void
+    format(fmt::BasicFormatter<char>& f, const char*& format_str, const signature& sig);
+}
+
+#endif //XMREG01_HEX_H
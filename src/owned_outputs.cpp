@@ -0,0 +1,374 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "owned_outputs.h"
+#include "parallel.h"
+#include "chain_scan.h"
+#include "hex.h"
+
+#include <unordered_map>
+#include <atomic>
+#include <sstream>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        /**
+         * Checkpoint record of a found output, i.e.,
+         * block timestamp, tx hash and output index
+         */
+        string
+        transfer_to_record(const transfer_details& td)
+        {
+            stringstream ss;
+
+            ss << td.m_block_timestamp << ' '
+               << pod_to_hex(td.tx_hash()) << ' '
+               << td.m_internal_output_index;
+
+            return ss.str();
+        }
+
+        /**
+         * Recreate found output from its checkpoint record.
+         * Only its tx has to be read from the blockchain.
+         */
+        bool
+        record_to_transfer(MicroCore& mcore,
+                           uint64_t blk_height,
+                           istream& record_in,
+                           transfer_details& td)
+        {
+            string tx_hash_str;
+            crypto::hash tx_hash;
+
+            td.m_block_height = blk_height;
+            td.m_spent        = false;
+
+            if (!(record_in >> td.m_block_timestamp >> tx_hash_str
+                            >> td.m_internal_output_index)
+                || !epee::string_tools::hex_to_pod(tx_hash_str, tx_hash))
+            {
+                cerr << "Incorrect checkpoint record in block: " << blk_height << endl;
+                return false;
+            }
+
+            if (!mcore.get_tx(tx_hash, td.m_tx))
+            {
+                cerr << "Cant get tx of checkpoint record: " << tx_hash_str
+                     << ", in block: " << blk_height << endl;
+                return false;
+            }
+
+            return true;
+        }
+    }
+
+
+    /**
+     * Go through all transactions in blocks of the given
+     * height range and collect outputs that belong to the given
+     * private view and public spend keys.
+     *
+     * If checkpoint is given, outputs found in previous runs
+     * are taken from it and the scan continues after
+     * the last block processed before.
+     *
+     * returns false if the scan was stopped, or a block could
+     * not be read, before reaching to_height. our_outputs
+     * then has the outputs found so far. Also returns false,
+     * without scanning, if an output stored in the checkpoint
+     * can't be restored, as it would be lost from the results.
+     */
+    bool
+    find_belonging_outputs(MicroCore& mcore,
+                           uint64_t from_height,
+                           uint64_t to_height,
+                           const secret_key& private_view_key,
+                           const public_key& public_spend_key,
+                           vector<transfer_details>& our_outputs,
+                           ScanCheckpoint* checkpoint)
+    {
+        our_outputs.clear();
+
+        if (checkpoint && checkpoint->resume_height(mcore, from_height))
+        {
+            for (const checkpoint_record& rec: checkpoint->records())
+            {
+                istringstream record_in {rec.data};
+
+                transfer_details td;
+
+                if (!record_to_transfer(mcore, rec.blk_height, record_in, td))
+                {
+                    return false;
+                }
+
+                our_outputs.push_back(td);
+            }
+        }
+
+        // prepare the keys once for all txs
+        OutputScanner scanner {private_view_key, public_spend_key};
+
+        return scan_blocks(mcore, from_height, to_height,
+                           [&](uint64_t blk_height, const block& blk,
+                               const list<transaction>& txs)
+        {
+            for (const transaction& tx: txs)
+            {
+                vector<transfer_details> found_outputs
+                        = get_belonging_outputs(blk, tx,
+                                                scanner,
+                                                blk_height);
+
+                for (const transfer_details& td: found_outputs)
+                {
+                    if (checkpoint)
+                    {
+                        checkpoint->add_record(blk_height, transfer_to_record(td));
+                    }
+
+                    our_outputs.push_back(td);
+                }
+            }
+        }, checkpoint);
+    }
+
+
+
+    /**
+     * Same as find_belonging_outputs, but for many accounts at once.
+     *
+     * Each block and tx is read from the blockchain only once,
+     * regardless of the number of accounts.
+     */
+    bool
+    find_accounts_outputs(MicroCore& mcore,
+                          uint64_t from_height,
+                          uint64_t to_height,
+                          const AccountSet& accounts,
+                          vector<account_transfer>& our_outputs,
+                          ScanCheckpoint* checkpoint)
+    {
+        our_outputs.clear();
+
+        if (checkpoint && checkpoint->resume_height(mcore, from_height))
+        {
+            for (const checkpoint_record& rec: checkpoint->records())
+            {
+                istringstream record_in {rec.data};
+
+                account_transfer out;
+
+                if (!(record_in >> out.account_idx) || out.account_idx >= accounts.size())
+                {
+                    cerr << "Incorrect account in checkpoint record in block: "
+                         << rec.blk_height << endl;
+                    return false;
+                }
+
+                if (!record_to_transfer(mcore, rec.blk_height, record_in, out.td))
+                {
+                    return false;
+                }
+
+                our_outputs.push_back(out);
+            }
+        }
+
+        return scan_blocks(mcore, from_height, to_height,
+                           [&](uint64_t blk_height, const block& blk,
+                               const list<transaction>& txs)
+        {
+            for (const transaction& tx: txs)
+            {
+                for (const account_output& out: accounts.get_belonging_outputs(tx))
+                {
+                    account_transfer found {
+                            out.account_idx,
+                            transfer_details {blk_height, blk.timestamp,
+                                              tx, out.output_index, false}
+                    };
+
+                    if (checkpoint)
+                    {
+                        checkpoint->add_record(blk_height,
+                                               to_string(found.account_idx) + " "
+                                               + transfer_to_record(found.td));
+                    }
+
+                    our_outputs.push_back(found);
+                }
+            }
+        }, checkpoint);
+    }
+
+
+
+    /**
+     * Generate key images of our outputs. This requires
+     * the private spend key.
+     *
+     * Each output is independent of the others, so
+     * they are spread across thread_no threads.
+     */
+    void
+    generate_key_images(vector<owned_output_status>& outputs,
+                        const secret_key& private_view_key,
+                        const secret_key& private_spend_key,
+                        const public_key& public_spend_key,
+                        size_t thread_no)
+    {
+        parallel_for(outputs.size(), [&](size_t i)
+        {
+            owned_output_status& out = outputs[i];
+
+            public_key pub_tx_key = read_tx_pub_key(out.td.m_tx);
+
+            key_derivation derivation;
+
+            if (!generate_key_derivation(pub_tx_key, private_view_key, derivation))
+            {
+                out.key_image_ok = false;
+                return;
+            }
+
+            out.key_image_ok = generate_key_image(derivation,
+                                                  out.td.m_internal_output_index,
+                                                  private_spend_key,
+                                                  public_spend_key,
+                                                  out.k_image);
+        }, thread_no);
+    }
+
+
+
+    /**
+     * Check which of the key images are already
+     * in the blockchain, i.e., which outputs are spent.
+     *
+     * Lookups are done in parallel, each thread
+     * using its own read transaction.
+     *
+     * returns number of spent outputs
+     */
+    size_t
+    check_key_images_spent(MicroCore& mcore,
+                           vector<owned_output_status>& outputs,
+                           size_t thread_no)
+    {
+        BlockchainDB& db = mcore.get_core().get_db();
+
+        atomic<size_t> spent_no {0};
+
+        parallel_for(outputs.size(), [&](size_t i)
+        {
+            owned_output_status& out = outputs[i];
+
+            if (!out.key_image_ok)
+            {
+                return;
+            }
+
+            out.spent = db.has_key_image(out.k_image);
+
+            if (out.spent)
+            {
+                ++spent_no;
+            }
+        }, thread_no);
+
+        return spent_no;
+    }
+
+
+
+    /**
+     * For spent outputs find transactions which spent them.
+     *
+     * Blockchain has no index of key images to transactions,
+     * so we make one pass through blocks, starting from the
+     * oldest spent output, and look for our key images
+     * in the inputs. The pass stops as soon as all
+     * spent outputs are accounted for.
+     */
+    bool
+    find_spending_txs(MicroCore& mcore,
+                      vector<owned_output_status>& outputs,
+                      uint64_t to_height)
+    {
+        unordered_map<key_image, size_t> spent_key_images;
+
+        uint64_t from_height = to_height;
+
+        for (size_t i = 0; i < outputs.size(); ++i)
+        {
+            const owned_output_status& out = outputs[i];
+
+            if (!out.spent)
+            {
+                continue;
+            }
+
+            spent_key_images[out.k_image] = i;
+            from_height = min(from_height, out.td.m_block_height);
+        }
+
+        for (uint64_t blk_height = from_height;
+             blk_height <= to_height && !spent_key_images.empty();
+             ++blk_height)
+        {
+            block blk;
+
+            if (!mcore.get_block_by_height(blk_height, blk))
+            {
+                cerr << "Cant get block of height: " << blk_height << endl;
+                return false;
+            }
+
+            list<transaction> txs;
+
+            if (!mcore.get_block_txs(blk, txs))
+            {
+                cerr << "Cant get transactions in block: " << blk_height << endl;
+                return false;
+            }
+
+            for (const transaction& tx: txs)
+            {
+                for (const txin_v& tx_in: tx.vin)
+                {
+                    if (tx_in.type() != typeid(txin_to_key))
+                    {
+                        continue;
+                    }
+
+                    const txin_to_key& tx_in_to_key
+                            = boost::get<txin_to_key>(tx_in);
+
+                    auto it = spent_key_images.find(tx_in_to_key.k_image);
+
+                    if (it == spent_key_images.end())
+                    {
+                        continue;
+                    }
+
+                    owned_output_status& out = outputs[it->second];
+
+                    out.spending_tx_hash    = get_transaction_hash(tx);
+                    out.spending_blk_height = blk_height;
+
+                    spent_key_images.erase(it);
+                }
+            }
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,85 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_OWNED_OUTPUTS_H
+#define XMREG01_OWNED_OUTPUTS_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "tx_details.h"
+#include "AccountSet.h"
+#include "ScanCheckpoint.h"
+
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * An output that belongs to us, together with its key image
+     * and, if it was spent, where it was spent.
+     */
+    struct owned_output_status
+    {
+        transfer_details td;
+        key_image        k_image;
+        bool             key_image_ok {false};
+        bool             spent {false};
+        crypto::hash     spending_tx_hash {null_hash};
+        uint64_t         spending_blk_height {0};
+    };
+
+
+    /**
+     * Output that belongs to one of the accounts
+     * of an AccountSet
+     */
+    struct account_transfer
+    {
+        size_t           account_idx;
+        transfer_details td;
+    };
+
+
+    bool
+    find_belonging_outputs(MicroCore& mcore,
+                           uint64_t from_height,
+                           uint64_t to_height,
+                           const secret_key& private_view_key,
+                           const public_key& public_spend_key,
+                           vector<transfer_details>& our_outputs,
+                           ScanCheckpoint* checkpoint = nullptr);
+
+    bool
+    find_accounts_outputs(MicroCore& mcore,
+                          uint64_t from_height,
+                          uint64_t to_height,
+                          const AccountSet& accounts,
+                          vector<account_transfer>& our_outputs,
+                          ScanCheckpoint* checkpoint = nullptr);
+
+    void
+    generate_key_images(vector<owned_output_status>& outputs,
+                        const secret_key& private_view_key,
+                        const secret_key& private_spend_key,
+                        const public_key& public_spend_key,
+                        size_t thread_no = 0);
+
+    size_t
+    check_key_images_spent(MicroCore& mcore,
+                           vector<owned_output_status>& outputs,
+                           size_t thread_no = 0);
+
+    bool
+    find_spending_txs(MicroCore& mcore,
+                      vector<owned_output_status>& outputs,
+                      uint64_t to_height);
+
+}
+
+#endif //XMREG01_OWNED_OUTPUTS_H
@@ -0,0 +1,98 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_PARALLEL_H
+#define XMREG01_PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+
+namespace xmreg
+{
+    using namespace std;
+
+
+    /**
+     * Number of worker threads to use. If thread_no
+     * is zero, as many as there are cores.
+     */
+    inline size_t
+    get_thread_no(size_t thread_no = 0)
+    {
+        if (thread_no > 0)
+        {
+            return thread_no;
+        }
+
+        size_t cores_no = thread::hardware_concurrency();
+
+        return cores_no > 0 ? cores_no : 1;
+    }
+
+
+    /**
+     * Split [0, item_no) range into contiguous chunks,
+     * one per thread, and call f(begin, end, thread_idx)
+     * for each of them in a separate thread.
+     *
+     * Returns when all chunks are processed.
+     */
+    template <typename F>
+    void
+    parallel_chunks(size_t item_no, F f, size_t thread_no = 0)
+    {
+        thread_no = min(get_thread_no(thread_no), max<size_t>(item_no, 1));
+
+        if (thread_no == 1)
+        {
+            f(size_t {0}, item_no, size_t {0});
+            return;
+        }
+
+        size_t chunk_size = (item_no + thread_no - 1) / thread_no;
+
+        vector<thread> workers;
+
+        for (size_t t = 0; t < thread_no; ++t)
+        {
+            size_t begin = t * chunk_size;
+            size_t end   = min(begin + chunk_size, item_no);
+
+            if (begin >= end)
+            {
+                break;
+            }
+
+            workers.emplace_back(f, begin, end, t);
+        }
+
+        for (thread& worker: workers)
+        {
+            worker.join();
+        }
+    }
+
+
+    /**
+     * Call f(i) for each i in [0, item_no),
+     * spread across thread_no threads.
+     */
+    template <typename F>
+    void
+    parallel_for(size_t item_no, F f, size_t thread_no = 0)
+    {
+        parallel_chunks(item_no, [&](size_t begin, size_t end, size_t)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                f(i);
+            }
+        }, thread_no);
+    }
+
+}
+
+#endif //XMREG01_PARALLEL_H
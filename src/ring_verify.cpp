@@ -0,0 +1,212 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "ring_verify.h"
+#include "chain_scan.h"
+#include "parallel.h"
+
+#include "../ext/format.h"
+
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+
+
+namespace xmreg
+{
+
+    namespace
+    {
+        // number of blocks each thread verifies at a time
+        const uint64_t VERIFY_CHUNK_SIZE {1000};
+    }
+
+
+    /**
+     * Check ring signature of in_i input of the given tx
+     * against public keys of its ring members, as
+     * the daemon does when it accepts the tx.
+     *
+     * prefix_hash is the hash of the tx prefix,
+     * i.e., of the tx without its signatures.
+     *
+     * returns false for coinbase inputs
+     */
+    bool
+    verify_input(MicroCore& mcore,
+                 const transaction& tx,
+                 const crypto::hash& prefix_hash,
+                 size_t in_i,
+                 input_verification& result)
+    {
+        result = input_verification {};
+
+        result.in_i = in_i;
+
+        const txin_v& tx_in = tx.vin[in_i];
+
+        if (tx_in.type() == typeid(txin_gen))
+        {
+            result.is_coinbase = true;
+            return false;
+        }
+
+        const txin_to_key& tx_in_to_key = boost::get<txin_to_key>(tx_in);
+
+        if (in_i >= tx.signatures.size()
+            || tx.signatures[in_i].size() != tx_in_to_key.key_offsets.size())
+        {
+            result.error = "number of signatures does not match ring size";
+            return true;
+        }
+
+        vector<uint64_t> absolute_offsets
+                = relative_output_offsets_to_absolute(tx_in_to_key.key_offsets);
+
+        vector<output_data_t> outputs;
+
+        try
+        {
+            mcore.get_core().get_db().get_output_key(tx_in_to_key.amount,
+                                                     absolute_offsets,
+                                                     outputs);
+        }
+        catch (const std::exception& e)
+        {
+            result.error = fmt::format("cant get ring member keys: {}", e.what());
+            return true;
+        }
+
+        if (outputs.size() != absolute_offsets.size())
+        {
+            result.error = "cant get all ring member keys";
+            return true;
+        }
+
+        vector<const public_key*> ring_keys;
+        ring_keys.reserve(outputs.size());
+
+        for (const output_data_t& output: outputs)
+        {
+            ring_keys.push_back(&output.pubkey);
+        }
+
+        result.valid = check_ring_signature(prefix_hash,
+                                            tx_in_to_key.k_image,
+                                            ring_keys,
+                                            tx.signatures[in_i].data());
+
+        return true;
+    }
+
+
+    /**
+     * Check ring signatures of all inputs of the given tx,
+     * spreading the inputs across threads.
+     */
+    vector<input_verification>
+    verify_tx(MicroCore& mcore,
+              const transaction& tx,
+              size_t thread_no)
+    {
+        vector<input_verification> results(tx.vin.size());
+
+        crypto::hash prefix_hash = get_transaction_prefix_hash(tx);
+
+        parallel_for(tx.vin.size(), [&](size_t in_i)
+        {
+            verify_input(mcore, tx, prefix_hash, in_i, results[in_i]);
+        }, thread_no);
+
+        return results;
+    }
+
+
+    /**
+     * Check ring signatures of all txs in the given height
+     * range. Blocks are verified in parallel, and only
+     * failed inputs are kept, in height order.
+     *
+     * returns false if the scan was stopped by a signal,
+     * or a block could not be read
+     */
+    bool
+    verify_range(MicroCore& mcore,
+                 uint64_t from_height,
+                 uint64_t to_height,
+                 range_verification& summary,
+                 size_t thread_no)
+    {
+        atomic<uint64_t> tx_no {0};
+        atomic<uint64_t> signature_no {0};
+        atomic<uint64_t> ring_member_no {0};
+
+        vector<failed_input> failed;
+        mutex failed_mutex;
+
+        // set by the scan only if a block cant be read
+        uint64_t unreadable_height {numeric_limits<uint64_t>::max()};
+
+        bool completed = parallel_scan_blocks(
+                mcore, from_height, to_height, VERIFY_CHUNK_SIZE,
+                [&](size_t, uint64_t blk_height,
+                    const block&, const list<transaction>& txs)
+        {
+            input_verification result;
+
+            for (const transaction& tx: txs)
+            {
+                if (tx.vin.empty() || tx.vin[0].type() == typeid(txin_gen))
+                {
+                    continue;
+                }
+
+                ++tx_no;
+
+                crypto::hash prefix_hash = get_transaction_prefix_hash(tx);
+
+                for (size_t in_i = 0; in_i < tx.vin.size(); ++in_i)
+                {
+                    if (!verify_input(mcore, tx, prefix_hash, in_i, result))
+                    {
+                        continue;
+                    }
+
+                    ++signature_no;
+                    ring_member_no += tx.signatures.size() > in_i
+                                      ? tx.signatures[in_i].size() : 0;
+
+                    if (!result.valid)
+                    {
+                        lock_guard<mutex> lock {failed_mutex};
+
+                        failed.push_back(failed_input {
+                                blk_height, get_transaction_hash(tx), result});
+                    }
+                }
+            }
+        }, thread_no, &unreadable_height);
+
+        stable_sort(failed.begin(), failed.end(),
+                    [](const failed_input& a, const failed_input& b)
+                    {
+                        return a.blk_height < b.blk_height;
+                    });
+
+        summary.tx_no          = tx_no;
+        summary.signature_no   = signature_no;
+        summary.ring_member_no = ring_member_no;
+        summary.failed         = std::move(failed);
+
+        if (unreadable_height != numeric_limits<uint64_t>::max())
+        {
+            summary.read_failed       = true;
+            summary.unreadable_height = unreadable_height;
+        }
+
+        return completed;
+    }
+
+}
@@ -0,0 +1,83 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_RING_VERIFY_H
+#define XMREG01_RING_VERIFY_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Result of checking ring signature of a single input.
+     * error is set when the signature could not be checked,
+     * e.g., ring member keys are missing.
+     */
+    struct input_verification
+    {
+        size_t   in_i {0};
+        bool     is_coinbase {false};
+        bool     valid {false};
+        string   error;
+    };
+
+
+    /**
+     * Input which ring signature failed in a range scan
+     */
+    struct failed_input
+    {
+        uint64_t     blk_height;
+        crypto::hash tx_hash;
+        input_verification result;
+    };
+
+
+    /**
+     * Summary of verifying all signatures in a height range.
+     * read_failed is set when a block, or its txs, could
+     * not be read, and unreadable_height is its height.
+     */
+    struct range_verification
+    {
+        uint64_t tx_no {0};
+        uint64_t signature_no {0};
+        uint64_t ring_member_no {0};
+        vector<failed_input> failed;
+        bool     read_failed {false};
+        uint64_t unreadable_height {0};
+    };
+
+
+    bool
+    verify_input(MicroCore& mcore,
+                 const transaction& tx,
+                 const crypto::hash& prefix_hash,
+                 size_t in_i,
+                 input_verification& result);
+
+    vector<input_verification>
+    verify_tx(MicroCore& mcore,
+              const transaction& tx,
+              size_t thread_no = 0);
+
+    bool
+    verify_range(MicroCore& mcore,
+                 uint64_t from_height,
+                 uint64_t to_height,
+                 range_verification& summary,
+                 size_t thread_no = 0);
+
+}
+
+#endif //XMREG01_RING_VERIFY_H
@@ -0,0 +1,186 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#include "spend_age.h"
+#include "parallel.h"
+
+#include <algorithm>
+
+
+namespace xmreg
+{
+
+    const size_t spend_age_stats::AGE_BUCKET_NO;
+
+
+    namespace
+    {
+        // upper limits of age buckets, in seconds,
+        // apart from the last one, which has no limit
+        const array<uint64_t, spend_age_stats::AGE_BUCKET_NO - 1> AGE_BUCKET_LIMITS {{
+                3600, 24 * 3600, 7 * 24 * 3600, 30 * 24 * 3600, 365 * 24 * 3600}};
+
+        const array<const char*, spend_age_stats::AGE_BUCKET_NO> AGE_BUCKET_NAMES {{
+                "< 1 hour", "< 1 day", "< 1 week", "< 1 month", "< 1 year", ">= 1 year"}};
+    }
+
+
+    /**
+     * For each of our spent outputs, find the input spending
+     * it, using its key image, and where the output is in
+     * the input's ring. The view and spend keys make this
+     * the ground truth that ring analyses can be checked on.
+     *
+     * outputs must have key images and spending txs,
+     * i.e., as set by find_spending_txs. Spends are
+     * looked up in parallel, and returned in the order
+     * of the outputs, unspent ones skipped.
+     */
+    vector<real_spend>
+    find_real_spends(MicroCore& mcore,
+                     const vector<owned_output_status>& outputs,
+                     const vector<uint64_t>& global_indices,
+                     size_t thread_no)
+    {
+        vector<size_t> spent_idxs;
+
+        for (size_t i = 0; i < outputs.size(); ++i)
+        {
+            if (outputs[i].spent && outputs[i].spending_tx_hash != null_hash)
+            {
+                spent_idxs.push_back(i);
+            }
+        }
+
+        vector<real_spend> spends(spent_idxs.size());
+
+        parallel_for(spent_idxs.size(), [&](size_t i)
+        {
+            const owned_output_status& out = outputs[spent_idxs[i]];
+
+            real_spend& spend = spends[i];
+
+            spend.output_idx = spent_idxs[i];
+            spend.blk_height = out.spending_blk_height;
+            spend.tx_hash    = out.spending_tx_hash;
+
+            transaction tx;
+
+            if (!mcore.get_tx(out.spending_tx_hash, tx))
+            {
+                return;
+            }
+
+            for (size_t in_i = 0; in_i < tx.vin.size(); ++in_i)
+            {
+                if (tx.vin[in_i].type() != typeid(txin_to_key))
+                {
+                    continue;
+                }
+
+                const txin_to_key& tx_in_to_key = boost::get<txin_to_key>(tx.vin[in_i]);
+
+                if (tx_in_to_key.k_image != out.k_image)
+                {
+                    continue;
+                }
+
+                // absolute offsets are sorted, and newer
+                // outputs have higher global indices
+                vector<uint64_t> absolute_offsets
+                        = relative_output_offsets_to_absolute(tx_in_to_key.key_offsets);
+
+                auto it = find(absolute_offsets.begin(), absolute_offsets.end(),
+                               global_indices[spend.output_idx]);
+
+                if (it == absolute_offsets.end())
+                {
+                    return;
+                }
+
+                spend.found       = true;
+                spend.in_i        = in_i;
+                spend.ring_size   = absolute_offsets.size();
+                spend.rank        = absolute_offsets.end() - it - 1;
+                spend.age_blocks  = spend.blk_height - out.td.m_block_height;
+
+                uint64_t spend_timestamp = mcore.get_blk_timestamp(spend.blk_height);
+
+                spend.age_seconds = spend_timestamp > out.td.m_block_timestamp
+                                    ? spend_timestamp - out.td.m_block_timestamp : 0;
+
+                return;
+            }
+        }, thread_no);
+
+        return spends;
+    }
+
+
+    /**
+     * Aggregate ranks and ages of the found spends
+     */
+    spend_age_stats
+    get_spend_age_stats(const vector<real_spend>& spends)
+    {
+        spend_age_stats stats;
+
+        vector<uint64_t> ages;
+
+        for (const real_spend& spend: spends)
+        {
+            if (!spend.found)
+            {
+                continue;
+            }
+
+            ++stats.spend_no;
+
+            if (stats.rank_counts.size() <= spend.rank)
+            {
+                stats.rank_counts.resize(spend.rank + 1, 0);
+            }
+
+            ++stats.rank_counts[spend.rank];
+
+            stats.newest_no += spend.rank == 0;
+            stats.oldest_no += spend.rank + 1 == spend.ring_size;
+
+            size_t bucket_idx = upper_bound(AGE_BUCKET_LIMITS.begin(),
+                                            AGE_BUCKET_LIMITS.end(),
+                                            spend.age_seconds)
+                                - AGE_BUCKET_LIMITS.begin();
+
+            ++stats.age_counts[bucket_idx];
+
+            ages.push_back(spend.age_blocks);
+        }
+
+        if (!ages.empty())
+        {
+            nth_element(ages.begin(), ages.begin() + ages.size() / 2, ages.end());
+
+            stats.median_age_blocks = ages[ages.size() / 2];
+
+            uint64_t age_sum {0};
+
+            for (uint64_t age: ages)
+            {
+                age_sum += age;
+            }
+
+            stats.mean_age_blocks = static_cast<double>(age_sum) / ages.size();
+        }
+
+        return stats;
+    }
+
+
+    const char*
+    age_bucket_name(size_t bucket_idx)
+    {
+        return AGE_BUCKET_NAMES[bucket_idx];
+    }
+
+}
@@ -0,0 +1,80 @@
+//
+// Created by mwo on 18/10/26.
+//
+
+#ifndef XMREG01_SPEND_AGE_H
+#define XMREG01_SPEND_AGE_H
+
+#include "monero_headers.h"
+#include "MicroCore.h"
+#include "owned_outputs.h"
+
+#include <vector>
+#include <array>
+
+namespace xmreg
+{
+    using namespace cryptonote;
+    using namespace crypto;
+    using namespace std;
+
+
+    /**
+     * Input spending one of our outputs, with the age of
+     * the output when spent, and its rank in the ring by age:
+     * 0 if it is the newest member, ring_size - 1 if the oldest.
+     *
+     * found is false if the input or the output in its
+     * ring could not be found.
+     */
+    struct real_spend
+    {
+        size_t       output_idx {0};
+        bool         found {false};
+        uint64_t     blk_height {0};
+        crypto::hash tx_hash {null_hash};
+        size_t       in_i {0};
+        size_t       ring_size {0};
+        size_t       rank {0};
+        uint64_t     age_blocks {0};
+        uint64_t     age_seconds {0};
+    };
+
+
+    /**
+     * Distributions of ranks and ages of real spends
+     */
+    struct spend_age_stats
+    {
+        static const size_t AGE_BUCKET_NO = 6;
+
+        size_t spend_no {0};
+
+        // rank_counts[r]: spends which were the r-th newest member
+        vector<size_t> rank_counts;
+
+        size_t newest_no {0};
+        size_t oldest_no {0};
+
+        array<size_t, AGE_BUCKET_NO> age_counts {};
+
+        uint64_t median_age_blocks {0};
+        double   mean_age_blocks {0};
+    };
+
+
+    vector<real_spend>
+    find_real_spends(MicroCore& mcore,
+                     const vector<owned_output_status>& outputs,
+                     const vector<uint64_t>& global_indices,
+                     size_t thread_no = 0);
+
+    spend_age_stats
+    get_spend_age_stats(const vector<real_spend>& spends);
+
+    const char*
+    age_bucket_name(size_t bucket_idx);
+
+}
+
+#endif //XMREG01_SPEND_AGE_H
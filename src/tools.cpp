@@ -44,6 +44,7 @@ namespace xmreg
     template bool parse_str_secret_key<crypto::secret_key>(const string& key_str, crypto::secret_key& secret_key);
     template bool parse_str_secret_key<crypto::public_key>(const string& key_str, crypto::public_key& secret_key);
     template bool parse_str_secret_key<crypto::hash>(const string& key_str, crypto::hash& secret_key);
+    template bool parse_str_secret_key<crypto::key_image>(const string& key_str, crypto::key_image& secret_key);
 
     /**
      * Get transaction tx using given tx hash. Hash is represent as string here,
@@ -102,12 +103,18 @@ namespace xmreg
     string
     print_sig (const signature& sig)
     {
-        stringstream ss;
+        // c: <hex of c> r: <hex of r>
+        string str(4 + 2 * sizeof(sig.c) + 6 + 2 * sizeof(sig.r) + 1, '\0');
 
-        ss << "c: <" << epee::string_tools::pod_to_hex(sig.c) << "> "
-           << "r: <" << epee::string_tools::pod_to_hex(sig.r) << ">";
+        char* out = &str[0];
 
-        return ss.str();
+        out = copy_n("c: <", 4, out);
+        out += hex_encode(&sig.c, sizeof(sig.c), out);
+        out = copy_n("> r: <", 6, out);
+        out += hex_encode(&sig.r, sizeof(sig.r), out);
+        *out = '>';
+
+        return str;
     }
 
     /**
@@ -271,6 +278,8 @@ namespace xmreg
     /**
      * Rough estimate of block height from the time provided
      *
+     * It assumes 60 seconds blocks, so it is far off for recent
+     * dates. MicroCore::height_for_time gives exact heights.
      */
     uint64_t
     estimate_bc_height(const string& date, const char* format)
@@ -298,6 +307,34 @@ namespace xmreg
     }
 
 
+    /**
+     * Convert date, taken as UTC, into unix timestamp
+     */
+    uint64_t
+    date_to_timestamp(const string& date, const char* format)
+    {
+        const pt::ptime UNIX_EPOCH {gt::date(1970,01,01)};
+
+        dateparser parser {format};
+
+        if (!parser(date))
+        {
+            throw runtime_error(string("Date format is incorrect: ") + date);
+        }
+
+        pt::ptime requested_date = parser.pt;
+
+        if (requested_date < UNIX_EPOCH)
+        {
+            return 0;
+        }
+
+        pt::time_duration td = requested_date - UNIX_EPOCH;
+
+        return static_cast<uint64_t>(td.total_seconds());
+    }
+
+
     array<size_t, 5>
     timestamp_difference(uint64_t t1, uint64_t t2)
     {
@@ -339,12 +376,30 @@ namespace xmreg
     timestamps_time_scale(const vector<uint64_t>& timestamps,
                           uint64_t timeN, uint64_t time0)
     {
-        string empty_time =  string("_______________________________")
-                            + string("______________________________")
-                            + string("______________________________")
-                            + string("______________________________");
+        string time_scale;
+
+        append_timestamps_time_scale(timestamps, time_scale, timeN, time0);
+
+        return time_scale;
+    }
+
+
+    /**
+     * Same as timestamps_time_scale, but the scale is added
+     * at the end of time_scale, e.g., to reuse its memory
+     */
+    void
+    append_timestamps_time_scale(const vector<uint64_t>& timestamps,
+                                 string& time_scale,
+                                 uint64_t timeN, uint64_t time0)
+    {
+        const size_t time_axis_length = 121;
+
+        size_t begin = time_scale.size();
 
-        size_t time_axis_length = empty_time.size();
+        time_scale.append(time_axis_length, '_');
+
+        char* empty_time = &time_scale[begin];
 
         uint64_t interval_length = timeN-time0;
 
@@ -363,8 +418,6 @@ namespace xmreg
             //cout << timestamp_place << endl;
             empty_time[timestamp_place] = '*';
         }
-
-        return empty_time;
     }
 
 
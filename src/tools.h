@@ -9,6 +9,7 @@
 
 #include "monero_headers.h"
 #include "tx_details.h"
+#include "hex.h"
 
 #include "../ext/dateparser.h"
 
@@ -134,6 +135,9 @@ namespace xmreg
     uint64_t
     estimate_bc_height(const string& date, const char* format = "%Y-%m-%d");
 
+    uint64_t
+    date_to_timestamp(const string& date, const char* format = "%Y-%m-%d");
+
 
     inline double
     get_xmr(uint64_t core_amount)
@@ -149,6 +153,12 @@ namespace xmreg
                           uint64_t timeN,
                           uint64_t time0 = 1397818193 /* timestamp of the second block */);
 
+    void
+    append_timestamps_time_scale(const vector<uint64_t>& timestamps,
+                                 string& time_scale,
+                                 uint64_t timeN,
+                                 uint64_t time0 = 1397818193 /* timestamp of the second block */);
+
 
 
 }
@@ -50,13 +50,31 @@ namespace xmreg
                           const secret_key& private_view_key,
                           const public_key& public_spend_key,
                           uint64_t block_height)
+    {
+        return get_belonging_outputs(blk, tx,
+                                     OutputScanner {private_view_key, public_spend_key},
+                                     block_height);
+    }
+
+
+    /**
+     * Get tx outputs associated with the keys of the given scanner.
+     *
+     * When checking many txs, the same scanner should be reused,
+     * so that the public spend key is prepared only once.
+     */
+    vector<xmreg::transfer_details>
+    get_belonging_outputs(const block& blk,
+                          const transaction& tx,
+                          const OutputScanner& scanner,
+                          uint64_t block_height)
     {
         // vector to be returned
         vector<xmreg::transfer_details> our_outputs;
 
 
         // get transaction's public key
-        public_key pub_tx_key = get_tx_pub_key_from_extra(tx);
+        public_key pub_tx_key = read_tx_pub_key(tx);
 
         // check if transaction has valid public key
         // if no, then skip
@@ -81,11 +99,10 @@ namespace xmreg
         // to create, so called, derived key.
         key_derivation derivation;
 
-        if (!generate_key_derivation(pub_tx_key, private_view_key, derivation))
+        if (!scanner.generate_derivation(pub_tx_key, derivation))
         {
             cerr << "Cant get dervied key for: "  << "\n"
-                 << "pub_tx_key: " << private_view_key << " and "
-                 << "prv_view_key" << private_view_key << endl;
+                 << "pub_tx_key: " << pub_tx_key << endl;
             return our_outputs;
         }
 
@@ -113,10 +130,9 @@ namespace xmreg
             // if someone had sent us some xmr.
             public_key pubkey;
 
-            derive_public_key(derivation,
-                              i,
-                              public_spend_key,
-                              pubkey);
+            scanner.derive_public_key(derivation,
+                                      i,
+                                      pubkey);
 
             // get tx output public key
             const txout_to_key tx_out_to_key
@@ -154,9 +170,23 @@ namespace xmreg
                    const transaction& tx,
                    const secret_key& private_view_key,
                    const public_key& public_spend_key)
+    {
+        return is_output_ours(output_index, tx,
+                              OutputScanner {private_view_key, public_spend_key});
+    }
+
+
+    /**
+     * Check if given output (specified by output_index)
+     * is ours based on the keys of the given scanner
+     */
+    bool
+    is_output_ours(const size_t& output_index,
+                   const transaction& tx,
+                   const OutputScanner& scanner)
     {
         // get transaction's public key
-        public_key pub_tx_key = get_tx_pub_key_from_extra(tx);
+        public_key pub_tx_key = read_tx_pub_key(tx);
 
         // check if transaction has valid public key
         // if no, then skip
@@ -169,11 +199,10 @@ namespace xmreg
         // to create, so called, derived key.
         key_derivation derivation;
 
-        if (!generate_key_derivation(pub_tx_key, private_view_key, derivation))
+        if (!scanner.generate_derivation(pub_tx_key, derivation))
         {
             cerr << "Cant get dervied key for: "  << "\n"
-                 << "pub_tx_key: " << pub_tx_key  << " and "
-                 << "prv_view_key" << private_view_key << endl;
+                 << "pub_tx_key: " << pub_tx_key << endl;
 
             return false;
         }
@@ -184,10 +213,9 @@ namespace xmreg
         // if someone had sent us some xmr.
         public_key pubkey;
 
-        derive_public_key(derivation,
-                          output_index,
-                          public_spend_key,
-                          pubkey);
+        scanner.derive_public_key(derivation,
+                                  output_index,
+                                  pubkey);
 
         //cout << "\n" << tx.vout.size() << " " << output_index << endl;
 
@@ -210,31 +238,16 @@ namespace xmreg
     get_payment_id(const transaction& tx,
                    crypto::hash& payment_id)
     {
-
         payment_id = null_hash;
 
-        std::vector<tx_extra_field> tx_extra_fields;
+        tx_extra_field_view extra_nonce;
 
-        if(!parse_tx_extra(tx.extra, tx_extra_fields))
+        if (!read_tx_extra_nonce(tx, extra_nonce))
         {
             return false;
         }
 
-        tx_extra_nonce extra_nonce;
-
-        if (find_tx_extra_field_by_type(tx_extra_fields, extra_nonce))
-        {
-            if (!get_payment_id_from_tx_extra_nonce(extra_nonce.nonce, payment_id))
-            {
-                return false;
-            }
-        }
-        else
-        {
-            return false;
-        }
-
-        return true;
+        return nonce_payment_id(extra_nonce, payment_id);
     }
 
 
@@ -244,33 +257,48 @@ namespace xmreg
     {
         payment_id8 = null_hash8;
 
-        std::vector<tx_extra_field> tx_extra_fields;
+        tx_extra_field_view extra_nonce;
 
-        if(!parse_tx_extra(tx.extra, tx_extra_fields))
+        if (!read_tx_extra_nonce(tx, extra_nonce))
         {
             return false;
         }
 
-        tx_extra_nonce extra_nonce;
+        return nonce_encrypted_payment_id(extra_nonce, payment_id8);
+    }
 
-        if (find_tx_extra_field_by_type(tx_extra_fields, extra_nonce))
-        {
 
-            if (!get_encrypted_payment_id_from_tx_extra_nonce(extra_nonce.nonce, payment_id8))
-            {
-    //            if (decrypt_payment_id(payment_id8, addr.m_view_public_key, ptx.tx_key))
-    //            {
-    //                memcpy(payment_id8.data, payment_id8.data, 8);
-    //            }
-                return false;
-            }
-        }
-        else
+    /**
+     * Get both normal and encrypted payment id of the tx,
+     * reading its extra only once, instead of once for
+     * each of them as get_payment_id and
+     * get_encrypted_payment_id do.
+     *
+     * returns false if the tx has neither of them
+     */
+    bool
+    get_payment_ids(const transaction& tx,
+                    tx_payment_ids& payment_ids)
+    {
+        payment_ids = tx_payment_ids {};
+
+        tx_extra_field_view extra_nonce;
+
+        if (!read_tx_extra_nonce(tx, extra_nonce))
         {
             return false;
         }
 
-        return true;
+        payment_ids.has_encrypted_payment_id
+                = nonce_encrypted_payment_id(extra_nonce, payment_ids.encrypted_payment_id);
+
+        if (!payment_ids.has_encrypted_payment_id)
+        {
+            payment_ids.has_payment_id
+                    = nonce_payment_id(extra_nonce, payment_ids.payment_id);
+        }
+
+        return payment_ids.has_payment_id || payment_ids.has_encrypted_payment_id;
     }
 
 
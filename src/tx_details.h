@@ -11,6 +11,8 @@
 
 #include "monero_headers.h"
 #include "tools.h"
+#include "OutputScanner.h"
+#include "TxExtraReader.h"
 
 namespace xmreg
 {
@@ -39,6 +41,20 @@ namespace xmreg
     operator<<(ostream& os, const transfer_details& dt);
 
 
+    /**
+     * Payment id of a tx, either normal or encrypted,
+     * read from the extra nonce of the tx
+     */
+    struct tx_payment_ids
+    {
+        bool          has_payment_id {false};
+        crypto::hash  payment_id {null_hash};
+
+        bool          has_encrypted_payment_id {false};
+        crypto::hash8 encrypted_payment_id {null_hash8};
+    };
+
+
     vector<xmreg::transfer_details>
     get_belonging_outputs(const block& blk,
                           const transaction& tx,
@@ -46,12 +62,23 @@ namespace xmreg
                           const public_key& public_spend_key,
                           uint64_t block_height = 0);
 
+    vector<xmreg::transfer_details>
+    get_belonging_outputs(const block& blk,
+                          const transaction& tx,
+                          const OutputScanner& scanner,
+                          uint64_t block_height = 0);
+
     bool
     is_output_ours(const size_t& output_index,
                    const transaction& tx,
                    const secret_key& private_view_key,
                    const public_key& public_spend_key);
 
+    bool
+    is_output_ours(const size_t& output_index,
+                   const transaction& tx,
+                   const OutputScanner& scanner);
+
     bool
     get_payment_id(const transaction& tx,
                    crypto::hash& payment_id);
@@ -60,6 +87,10 @@ namespace xmreg
     get_encrypted_payment_id(const transaction& tx,
                              crypto::hash8& payment_id);
 
+    bool
+    get_payment_ids(const transaction& tx,
+                    tx_payment_ids& payment_ids);
+
 
 }
 